@@ -0,0 +1,210 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "bitboard.h"
+#include <cstring>
+
+namespace chess {
+
+Bitboard KNIGHT_ATTACKS[64];
+Bitboard KING_ATTACKS[64];
+Bitboard PAWN_ATTACKS[2][64];
+SliderMagic ROOK_MAGICS[64];
+SliderMagic BISHOP_MAGICS[64];
+Bitboard BETWEEN[64][64];
+Bitboard LINE[64][64];
+
+// shared attack tables for all squares. sizes are the
+// sum of 2^(relevant occupancy bits) over all squares
+static Bitboard ROOK_TABLE[0x19000];
+static Bitboard BISHOP_TABLE[0x1480];
+
+static const int ROOK_DIRS[4][2] = { {1,0}, {-1,0}, {0,1}, {0,-1} };
+static const int BISHOP_DIRS[4][2] = { {1,1}, {1,-1}, {-1,1}, {-1,-1} };
+
+// square at (file+df, rank+dr) as bitboard,
+// or empty if that square is off the board
+static Bitboard offset_bb(int sq, int df, int dr) {
+    int file = (sq & 7) + df;
+    int rank = (sq >> 3) + dr;
+    if(file < 0 || file > 7 || rank < 0 || rank > 7) {
+        return 0;
+    }
+    return sq_bb(rank * 8 + file);
+}
+
+// slow reference computation of slider attacks.
+// only used to fill the lookup tables
+static Bitboard slider_attacks(int sq, Bitboard occupied, const int dirs[4][2]) {
+    Bitboard attacks = 0;
+    for(int i=0;i<4;i++) {
+        int file = sq & 7;
+        int rank = sq >> 3;
+        for(;;) {
+            file += dirs[i][0];
+            rank += dirs[i][1];
+            if(file < 0 || file > 7 || rank < 0 || rank > 7) {
+                break;
+            }
+            Bitboard b = sq_bb(rank * 8 + file);
+            attacks |= b;
+            if(occupied & b) {
+                break;
+            }
+        }
+    }
+    return attacks;
+}
+
+// xorshift64* generator with fixed seed, so that
+// magic numbers are identical in every run
+class MagicRng
+{
+public:
+    MagicRng(quint64 seed) : s(seed) {}
+
+    quint64 rand64() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * Q_UINT64_C(2685821657736338717);
+    }
+
+    // random numbers with few set bits are
+    // much more likely to be magics
+    quint64 sparse_rand64() {
+        return rand64() & rand64() & rand64();
+    }
+
+private:
+    quint64 s;
+};
+
+static void init_slider(SliderMagic magics[64], Bitboard *table, const int dirs[4][2]) {
+
+    Bitboard occupancy[4096];
+    Bitboard reference[4096];
+    int epoch[4096];
+    std::memset(epoch, 0, sizeof(epoch));
+    int current_epoch = 0;
+
+    MagicRng rng(Q_UINT64_C(728));
+
+    Bitboard *next_table = table;
+    for(int sq=0;sq<64;sq++) {
+        // border squares never change the attack set,
+        // unless the slider itself is located on that border
+        Bitboard edges = ((BB_RANK_1 | BB_RANK_8) & ~(BB_RANK_1 << (8 * (sq >> 3))))
+                | ((Q_UINT64_C(0x0101010101010101) | Q_UINT64_C(0x8080808080808080))
+                   & ~(Q_UINT64_C(0x0101010101010101) << (sq & 7)));
+
+        SliderMagic &m = magics[sq];
+        m.mask = slider_attacks(sq, 0, dirs) & ~edges;
+        m.shift = 64 - popcount(m.mask);
+        m.attacks = next_table;
+
+        // enumerate all subsets of the mask (carry-rippler)
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slider_attacks(sq, b, dirs);
+#if defined(__BMI2__)
+            m.attacks[_pext_u64(b, m.mask)] = reference[size];
+#endif
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while(b);
+        next_table += size;
+
+#if defined(__BMI2__)
+        m.magic = 0;
+#else
+        // try random candidates until one maps all occupancies
+        // without destructive collisions
+        for(int i=0;i<size;) {
+            m.magic = 0;
+            while(popcount((m.magic * m.mask) >> 56) < 6) {
+                m.magic = rng.sparse_rand64();
+            }
+            current_epoch++;
+            for(i=0;i<size;i++) {
+                unsigned idx = m.index(occupancy[i]);
+                if(epoch[idx] < current_epoch) {
+                    epoch[idx] = current_epoch;
+                    m.attacks[idx] = reference[i];
+                } else if(m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+static bool compute_tables() {
+
+    for(int sq=0;sq<64;sq++) {
+        KNIGHT_ATTACKS[sq] = offset_bb(sq, 1, 2) | offset_bb(sq, 2, 1)
+                | offset_bb(sq, 2, -1) | offset_bb(sq, 1, -2)
+                | offset_bb(sq, -1, -2) | offset_bb(sq, -2, -1)
+                | offset_bb(sq, -2, 1) | offset_bb(sq, -1, 2);
+        KING_ATTACKS[sq] = offset_bb(sq, 1, 1) | offset_bb(sq, 1, 0)
+                | offset_bb(sq, 1, -1) | offset_bb(sq, 0, -1)
+                | offset_bb(sq, -1, -1) | offset_bb(sq, -1, 0)
+                | offset_bb(sq, -1, 1) | offset_bb(sq, 0, 1);
+        // WHITE == false == 0, BLACK == true == 1
+        PAWN_ATTACKS[0][sq] = offset_bb(sq, -1, 1) | offset_bb(sq, 1, 1);
+        PAWN_ATTACKS[1][sq] = offset_bb(sq, -1, -1) | offset_bb(sq, 1, -1);
+    }
+    init_slider(ROOK_MAGICS, ROOK_TABLE, ROOK_DIRS);
+    init_slider(BISHOP_MAGICS, BISHOP_TABLE, BISHOP_DIRS);
+    for(int sq1=0;sq1<64;sq1++) {
+        for(int sq2=0;sq2<64;sq2++) {
+            BETWEEN[sq1][sq2] = 0;
+            LINE[sq1][sq2] = 0;
+            if(sq1 == sq2) {
+                continue;
+            }
+            const int (*dirs)[2] = 0;
+            if(slider_attacks(sq1, 0, ROOK_DIRS) & sq_bb(sq2)) {
+                dirs = ROOK_DIRS;
+            } else if(slider_attacks(sq1, 0, BISHOP_DIRS) & sq_bb(sq2)) {
+                dirs = BISHOP_DIRS;
+            }
+            if(dirs) {
+                Bitboard b1 = sq_bb(sq1);
+                Bitboard b2 = sq_bb(sq2);
+                BETWEEN[sq1][sq2] = slider_attacks(sq1, b2, dirs) & slider_attacks(sq2, b1, dirs);
+                LINE[sq1][sq2] = (slider_attacks(sq1, 0, dirs) & slider_attacks(sq2, 0, dirs)) | b1 | b2;
+            }
+        }
+    }
+    return true;
+}
+
+void init_bitboards() {
+    // function local statics are initialized exactly once,
+    // even if several threads construct boards concurrently
+    static const bool initialized = compute_tables();
+    Q_UNUSED(initialized);
+}
+
+}
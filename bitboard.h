@@ -0,0 +1,183 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace chess {
+
+// BITBOARDS
+// a bitboard is a 64 bit set, where bit n corresponds to
+// square n with A1 = 0, B1 = 1, ..., H1 = 7, A2 = 8, ..., H8 = 63.
+// Board still uses the 10x12 mailbox for everything that is
+// visible from outside, i.e. moves and square indices
+// are always in internal (21 ... 98) format. Bitboards
+// are only used internally for move generation.
+typedef quint64 Bitboard;
+
+const Bitboard BB_RANK_1 = Q_UINT64_C(0x00000000000000FF);
+const Bitboard BB_RANK_2 = Q_UINT64_C(0x000000000000FF00);
+const Bitboard BB_RANK_7 = Q_UINT64_C(0x00FF000000000000);
+const Bitboard BB_RANK_8 = Q_UINT64_C(0xFF00000000000000);
+const Bitboard BB_FILE_A = Q_UINT64_C(0x0101010101010101);
+const Bitboard BB_ALL = Q_UINT64_C(0xFFFFFFFFFFFFFFFF);
+
+// maps internal board index to bitboard square,
+// -1 for fringe squares
+const int IDX_TO_SQ[120] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7, -1,
+    -1,  8,  9, 10, 11, 12, 13, 14, 15, -1,
+    -1, 16, 17, 18, 19, 20, 21, 22, 23, -1,
+    -1, 24, 25, 26, 27, 28, 29, 30, 31, -1,
+    -1, 32, 33, 34, 35, 36, 37, 38, 39, -1,
+    -1, 40, 41, 42, 43, 44, 45, 46, 47, -1,
+    -1, 48, 49, 50, 51, 52, 53, 54, 55, -1,
+    -1, 56, 57, 58, 59, 60, 61, 62, 63, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+inline int idx_to_sq(int idx) {
+    return IDX_TO_SQ[idx];
+}
+
+inline int sq_to_idx(int sq) {
+    return ((sq >> 3) * 10) + (sq & 7) + 21;
+}
+
+inline Bitboard sq_bb(int sq) {
+    return Q_UINT64_C(1) << sq;
+}
+
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return int(idx);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// returns index of least significant bit
+// and removes it from b. b must not be empty
+inline int pop_lsb(Bitboard &b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+inline int popcount(Bitboard b) {
+#if defined(_MSC_VER)
+    return int(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+/**
+ * @brief SliderMagic lookup data for one square of a sliding piece.
+ *        attack sets for all relevant occupancies are stored
+ *        in a shared table, indexed either by a magic multiplication
+ *        or (if the compiler targets BMI2) by PEXT.
+ */
+struct SliderMagic
+{
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    int shift;
+
+    inline unsigned index(Bitboard occupied) const {
+#if defined(__BMI2__)
+        return unsigned(_pext_u64(occupied, mask));
+#else
+        return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Bitboard KNIGHT_ATTACKS[64];
+extern Bitboard KING_ATTACKS[64];
+// [color][square], color is WHITE or BLACK
+extern Bitboard PAWN_ATTACKS[2][64];
+extern SliderMagic ROOK_MAGICS[64];
+extern SliderMagic BISHOP_MAGICS[64];
+// squares strictly between two squares on a common
+// rank, file or diagonal. empty if not aligned
+extern Bitboard BETWEEN[64][64];
+// full line through two aligned squares (edge to edge),
+// empty if not aligned
+extern Bitboard LINE[64][64];
+
+/**
+ * @brief init_bitboards computes all attack tables. Board calls this
+ *                       automatically on construction, and calling it
+ *                       more than once (also from several threads) is safe.
+ */
+void init_bitboards();
+
+inline Bitboard knight_attacks(int sq) {
+    return KNIGHT_ATTACKS[sq];
+}
+
+inline Bitboard king_attacks(int sq) {
+    return KING_ATTACKS[sq];
+}
+
+inline Bitboard pawn_attacks(bool color, int sq) {
+    return PAWN_ATTACKS[color][sq];
+}
+
+inline Bitboard rook_attacks(int sq, Bitboard occupied) {
+    const SliderMagic &m = ROOK_MAGICS[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishop_attacks(int sq, Bitboard occupied) {
+    const SliderMagic &m = BISHOP_MAGICS[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queen_attacks(int sq, Bitboard occupied) {
+    return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+}
+
+inline Bitboard between(int sq1, int sq2) {
+    return BETWEEN[sq1][sq2];
+}
+
+inline Bitboard line(int sq1, int sq2) {
+    return LINE[sq1][sq2];
+}
+
+}
+
+#endif // BITBOARD_H
@@ -40,50 +40,36 @@ Board::Board() {
     this->turn = WHITE;
     for(int i=0;i<120;i++) {
         this->board[i] = EMPTY_POS[i];
-        this->old_board[i] = 0xFF;
     }
-    this->init_piece_list();
+    this->init_occupancy();
     this->castle_wking_ok = false;
     this->castle_wqueen_ok = false;
     this->castle_bking_ok = false;
     this->castle_bqueen_ok = false;
-    this->prev_castle_wking_ok = false;
-    this->prev_castle_wqueen_ok = false;
-    this->prev_castle_bking_ok = false;
-    this->prev_castle_bqueen_ok = false;
     this->en_passent_target = 0;
     this->halfmove_clock = 0;
     this->fullmove_number = 1;
-    this->undo_available = false;
     this->last_was_null = false;
-    this->prev_halfmove_clock = 0;
-    this->zobrist_initialized = false;
-    this->pos_hash_initialized = false;
 }
 
-void Board::init_piece_list() {
+void Board::init_occupancy() {
 
+    chess::init_bitboards();
+    this->bb_color[WHITE] = 0;
+    this->bb_color[BLACK] = 0;
+    this->pos_hash = Q_UINT64_C(0);
     for(int i=0;i<7;i++) {
-        for(int j=0;j<10;j++) {
-            this->piece_list[WHITE][i][j] = EMPTY;
-            this->piece_list[BLACK][i][j] = EMPTY;
-        }
+        this->bb_piece[i] = 0;
     }
-    for(uint8_t i=21;i<99;i++) {
-        uint8_t piece = this->board[i];
+    for(int i=21;i<99;i++) {
+        int piece = this->board[i];
         if(!(piece == EMPTY) && !(piece == 0xFF)) {
             bool color = WHITE;
             if(piece > 0x80) {
                 piece = piece - 0x80;
                 color = BLACK;
             }
-            // piece contains now the piece type
-            for(int j=0;j<10;j++) {
-                if(this->piece_list[color][piece][j] == EMPTY) {
-                   this->piece_list[color][piece][j] = i;
-                   break;
-                }
-            }
+            this->add_to_bitboards(color, piece, i);
         }
     }
 }
@@ -94,7 +80,6 @@ Board::Board(bool initial_position) {
     if(initial_position) {
         for(int i=0;i<120;i++) {
             this->board[i] = chess::INIT_POS[i];
-            this->old_board[i] = 0xFF;
         }
         this->castle_wking_ok = true;
         this->castle_wqueen_ok = true;
@@ -109,19 +94,11 @@ Board::Board(bool initial_position) {
         this->castle_bking_ok = false;
         this->castle_bqueen_ok = false;
     }
-    this->init_piece_list();
+    this->init_occupancy();
     this->en_passent_target = 0;
     this->halfmove_clock = 0;
     this->fullmove_number = 1;
-    this->undo_available = false;
     this->last_was_null = false;
-    this->prev_halfmove_clock = 0;
-    this->prev_castle_wking_ok = false;
-    this->prev_castle_wqueen_ok = false;
-    this->prev_castle_bking_ok = false;
-    this->prev_castle_bqueen_ok = false;
-    this->zobrist_initialized = false;
-    this->pos_hash_initialized = false;
 }
 
 bool Board::is_initial_position() const {
@@ -148,7 +125,7 @@ bool Board::is_initial_position() const {
     if(this->fullmove_number != 1) {
         return false;
     }
-    if(this->undo_available) {
+    if(!this->history.isEmpty()) {
         return false;
     }
     return true;
@@ -209,7 +186,13 @@ void Board::set_piece_at(int x, int y, int piece) {
             ((piece >= 0x01 && piece <= 0x07) ||  // white piece
              (piece >= 0x81 && piece <= 0x87) || (piece == 0x00))) { // black piece or empty
         int idx = ((y+2)*10) + (x+1);
+        if(this->board[idx] != EMPTY) {
+            this->remove_from_bitboards(this->get_piece_color(idx), this->get_piece_type(idx), idx);
+        }
         this->board[idx] = piece;
+        if(piece != EMPTY) {
+            this->add_to_bitboards(this->get_piece_color(idx), this->get_piece_type(idx), idx);
+        }
     } else {
         throw std::invalid_argument("called set_piece_at with invalid paramters");
     }
@@ -299,7 +282,6 @@ QChar Board::piece_to_symbol(int piece) const {
 Board::Board(const QString &fen_string) {
     for(int i=0;i<120;i++) {
         this->board[i] = EMPTY_POS[i];
-        this->old_board[i] = 0xFF;
     }
 
     // check that we have six parts in fen, each separated by space
@@ -481,15 +463,12 @@ Board::Board(const QString &fen_string) {
     } else {
         this->fullmove_number = 1;
     }
-    this->undo_available = false;
     this->last_was_null = false;
-    this->init_piece_list();
+    this->init_occupancy();
     if(!this->is_consistent()) {
         throw std::invalid_argument("board position from supplied fen is inconsistent");
     }
 
-    this->zobrist_initialized = false;
-    this->pos_hash_initialized = false;
 }
 
 QString Board::idx_to_str(int idx) const {
@@ -602,12 +581,12 @@ void Board::set_castle_bqueen(bool can_do) {
     this->castle_bqueen_ok = can_do;
 }
 
-QVector<Move> Board::pseudo_legal_moves() {
+MoveList Board::pseudo_legal_moves() {
     //return this->pseudo_legal_moves_from(0,true,this->turn);
     return this->pseudo_legal_moves(chess::ANY_SQUARE, chess::ANY_SQUARE, chess::ANY_PIECE, true, this->turn);
 }
 
-QVector<Move> Board::pseudo_legal_moves(int to_square, int piece_type) {
+MoveList Board::pseudo_legal_moves(int to_square, int piece_type) {
     if(piece_type == KING) {
         //return this->pseudo_legal_moves_to(to_square, piece_type, true,this->turn);
         return this->pseudo_legal_moves(chess::ANY_SQUARE, to_square, piece_type, true, this->turn);
@@ -654,55 +633,35 @@ bool Board::is_castles_bqueen(const Move &m) const {
     }
 }
 
-// to get legal moves, just get list of pseudo
-// legals and then filter by checking each move's
-// legality
-QVector<Move> Board::legal_moves() {
+// legal moves are generated directly: checkers and
+// pinned pieces are computed once for the position,
+// and only moves that respect them are emitted.
+// no move is applied to test legality
+MoveList Board::legal_moves() {
 
-    QVector<Move> pseudo_legals = this->pseudo_legal_moves();
-    QVector<Move> legals;
-    for(int i=0;i<pseudo_legals.size();i++) {
-        Move m = pseudo_legals.at(i);
-        if(this->pseudo_is_legal_move(m)) {
-            legals.append(m);
-        }
-    }
+    MoveList legals;
+    this->generate_legal_moves(chess::ANY_SQUARE, chess::ANY_SQUARE, chess::ANY_PIECE, legals);
     return legals;
 }
 
 // to speed up san parsing, check here
 // only moves where destination is hit.
-QVector<Move> Board::legal_moves(int to_square, int piece_type) {
-
-    QVector<Move> pseudo_legals = this->pseudo_legal_moves(to_square, piece_type);
-    QVector<Move> legals;
-    for(int i=0;i<pseudo_legals.size();i++) {
-        Move m = pseudo_legals.at(i);
-        if(m.to == to_square) {
-            if(this->pseudo_is_legal_move(m)) {
-                legals.append(m);
-            }
-        }
-    }
+MoveList Board::legal_moves(int to_square, int piece_type) {
+
+    MoveList legals;
+    this->generate_legal_moves(chess::ANY_SQUARE, to_square, piece_type, legals);
     return legals;
 }
 
-QVector<Move> Board::legal_moves_from(int from_square) {
+MoveList Board::legal_moves_from(int from_square) {
 
-    QVector<Move> pseudo_legals = this->pseudo_legal_moves(from_square, chess::ANY_SQUARE, chess::ANY_PIECE, true,this->turn);
-
-    QVector<Move> legals;
-    for(int i=0;i<pseudo_legals.size();i++) {
-        Move m = pseudo_legals.at(i);
-        if(this->pseudo_is_legal_move(m)) {
-            legals.append(m);
-        }
-    }
+    MoveList legals;
+    this->generate_legal_moves(from_square, chess::ANY_SQUARE, chess::ANY_PIECE, legals);
     return legals;
 }
 
 bool Board::is_legal_and_promotes(const Move &m) {
-    QVector<Move> legals = this->legal_moves_from(m.from);
+    MoveList legals = this->legal_moves_from(m.from);
     for(int i=0;i<legals.size();i++) {
         Move mi = legals.at(i);
         if(mi.from == m.from && mi.to == m.to && mi.promotion_piece != 0) {
@@ -713,27 +672,122 @@ bool Board::is_legal_and_promotes(const Move &m) {
 }
 
 bool Board::is_legal_move(const Move &m) {
-    QVector<Move> pseudo_legals = this->pseudo_legal_moves(m.from, m.to, this->get_piece_type(m.from), true, this->turn);
-    for(int i=0;i<pseudo_legals.size();i++) {
-        Move mi = pseudo_legals.at(i);
-        if(mi == m && this->pseudo_is_legal_move(m)) {
+    if(m.is_null || this->is_offside(m.from) || this->is_offside(m.to)
+            || this->is_empty(m.from) || this->get_piece_color(m.from) != this->turn) {
+        return false;
+    }
+    MoveList legals;
+    this->generate_legal_moves(m.from, m.to, this->get_piece_type(m.from), legals);
+    for(int i=0;i<legals.size();i++) {
+        if(legals.at(i) == m) {
             return true;
         }
     }
     return false;
 }
 
-QVector<Move> Board::legals_from_pseudos(QVector<Move> &pseudos) {
-    QVector<Move> legals;
+MoveList Board::legals_from_pseudos(MoveList &pseudos) {
+    MoveList legals;
+    if(pseudos.isEmpty()) {
+        return legals;
+    }
+    bool color = this->get_piece_color(pseudos.at(0).from);
+    Bitboard kings = this->bb_color[color] & this->bb_piece[KING];
+    if(!kings) {
+        return legals;
+    }
+    int king_sq = lsb(kings);
+    Bitboard occupied = this->bb_color[WHITE] | this->bb_color[BLACK];
+    Bitboard checkers = this->attackers_to(king_sq, !color, occupied);
+    Bitboard pinned = this->pinned_pieces(king_sq, color);
     for(int i=0;i<pseudos.size();i++) {
         Move mi = pseudos.at(i);
-        if(pseudo_is_legal_move(mi)) {
+        // when not in check, a move of a piece that is neither
+        // pinned, nor the king, nor an en passent capture is legal
+        Bitboard from = sq_bb(idx_to_sq(mi.from));
+        if(!checkers && !(from & (pinned | kings)) && mi.to != this->en_passent_target) {
+            legals.append(mi);
+        } else if(this->pseudo_is_legal_move(mi)) {
             legals.append(mi);
         }
     }
     return legals;
 }
 
+bool Board::resolve_piece_move(int piece_type, int to_square, int from_col, int from_row, Move &m,
+                               bool trusted) {
+
+    bool turn = this->turn;
+    Bitboard own = this->bb_color[turn];
+    int to = idx_to_sq(to_square);
+    if(to < 0 || (own & sq_bb(to))) {
+        return false;
+    }
+    // all pieces attack symmetrically, so the pieces of piece_type
+    // that reach to are those attacked from to by such a piece
+    Bitboard occupied = own | this->bb_color[!turn];
+    Bitboard candidates = 0;
+    switch(piece_type) {
+    case KNIGHT:
+        candidates = knight_attacks(to);
+        break;
+    case BISHOP:
+        candidates = bishop_attacks(to, occupied);
+        break;
+    case ROOK:
+        candidates = rook_attacks(to, occupied);
+        break;
+    case QUEEN:
+        candidates = queen_attacks(to, occupied);
+        break;
+    case KING:
+        candidates = king_attacks(to);
+        break;
+    default:
+        return false;
+    }
+    candidates &= own & this->bb_piece[piece_type];
+    if(from_col >= 0) {
+        candidates &= BB_FILE_A << from_col;
+    }
+    if(from_row >= 0) {
+        candidates &= BB_RANK_1 << (8 * from_row);
+    }
+    if(!candidates) {
+        return false;
+    }
+    if(candidates & (candidates - 1)) {
+        // several pieces reach to, but usually all
+        // except one are pinned. filter them out
+        Bitboard kings = own & this->bb_piece[KING];
+        if(!kings) {
+            return false;
+        }
+        int king_sq = lsb(kings);
+        // a legal move to the same square resolves a check for any
+        // candidate alike, so for trusted moves only pins matter
+        bool in_check = !trusted && this->attackers_to(king_sq, !turn, occupied) != 0;
+        Bitboard pinned = this->pinned_pieces(king_sq, turn);
+        Bitboard legal = 0;
+        while(candidates) {
+            int from = pop_lsb(candidates);
+            if(in_check || piece_type == KING) {
+                if(this->pseudo_is_legal_move(Move(sq_to_idx(from), to_square))) {
+                    legal |= sq_bb(from);
+                }
+            } else if(!(pinned & sq_bb(from)) || (line(king_sq, from) & sq_bb(to))) {
+                legal |= sq_bb(from);
+            }
+        }
+        candidates = legal;
+        if(!candidates || (candidates & (candidates - 1))) {
+            return false;
+        }
+    }
+    m = Move(sq_to_idx(lsb(candidates)), to_square);
+    return true;
+}
+
 bool Board::pseudo_is_legal_move(const Move &m) {
 
     // a pseudo legal move is a legal move if
@@ -743,424 +797,399 @@ bool Board::pseudo_is_legal_move(const Move &m) {
     //                                3) doesn't castle into check
     // first find color of mover
     bool color = this->get_piece_color(m.from);
-    // find king with that color
-    for(int i= 21;i<99;i++) {
-        if(this->get_piece_type(i) == KING && this->get_piece_color(i) == color) {
-            // if the move is not by the king
-            if(i!=m.from) {
-                // apply the move, check if king is attacked, and decide
-                bool legal = false;
-                this->apply(m);
-                legal = !this->is_attacked(i,!color);
-                this->undo();
-                return legal;
-            } else {
-                // means we move the king
-                // first check castle cases
-                if(this->is_castles_wking(m)) {
-                    if(!this->is_attacked(E1,BLACK) && !this->is_attacked(F1,BLACK)
-                            && !this->is_attacked(G1,BLACK)) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(G1,BLACK);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                if(this->is_castles_bking(m)) {
-                    if(!this->is_attacked(E8,WHITE) && !this->is_attacked(F8,WHITE)
-                            && !this->is_attacked(G8,WHITE)) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(G8,WHITE);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                if(this->is_castles_wqueen(m)) {
-                    if(!this->is_attacked(E1,BLACK) && !this->is_attacked(D1,BLACK)
-                            && !this->is_attacked(C1,BLACK) ) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(C1,BLACK);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                if(this->is_castles_bqueen(m)) {
-                    if(!this->is_attacked(E8,WHITE) && !this->is_attacked(D8,WHITE)
-                            && !this->is_attacked(C8,WHITE) ) {
-                        bool legal = false;
-                        this->apply(m);
-                        legal = !this->is_attacked(C8,WHITE);
-                        this->undo();
-                        return legal;
-                    } else {
-                        return false;
-                    }
-                }
-                // if none of the castles cases triggered, we have a standard king move
-                // just check if king isn't attacked after applying the move
-                bool legal = false;
-                this->apply(m);
-                legal = !this->is_attacked(m.to,!color);
-                this->undo();
-                return legal;
-            }
+    Bitboard kings = this->bb_color[color] & this->bb_piece[KING];
+    if(!kings) {
+        return false;
+    }
+    int king_sq = lsb(kings);
+    int from = idx_to_sq(m.from);
+    int to = idx_to_sq(m.to);
+    if(king_sq == from) {
+        // means we move the king
+        // first check castle cases
+        if(this->is_castles_wking(m)) {
+            return !this->is_attacked(E1,BLACK) && !this->is_attacked(F1,BLACK)
+                    && !this->is_attacked(G1,BLACK);
+        }
+        if(this->is_castles_bking(m)) {
+            return !this->is_attacked(E8,WHITE) && !this->is_attacked(F8,WHITE)
+                    && !this->is_attacked(G8,WHITE);
+        }
+        if(this->is_castles_wqueen(m)) {
+            return !this->is_attacked(E1,BLACK) && !this->is_attacked(D1,BLACK)
+                    && !this->is_attacked(C1,BLACK);
+        }
+        if(this->is_castles_bqueen(m)) {
+            return !this->is_attacked(E8,WHITE) && !this->is_attacked(D8,WHITE)
+                    && !this->is_attacked(C8,WHITE);
+        }
+    }
+    // otherwise construct the occupancy after the move and
+    // check whether any (not captured) enemy piece then attacks the king
+    Bitboard occupied = this->bb_color[WHITE] | this->bb_color[BLACK];
+    occupied = (occupied & ~sq_bb(from)) | sq_bb(to);
+    Bitboard captured = sq_bb(to);
+    if(this->get_piece_type(m.from) == PAWN && m.to == this->en_passent_target
+            && this->en_passent_target != 0) {
+        int ep_victim = to - 8;
+        if(color == BLACK) {
+            ep_victim = to + 8;
         }
+        occupied &= ~sq_bb(ep_victim);
+        captured |= sq_bb(ep_victim);
     }
-    return false;
+    if(king_sq == from) {
+        king_sq = to;
+    }
+    return !(this->attackers_to(king_sq, !color, occupied) & ~captured);
 }
 
-// doesn't account for attacks via en-passent
-bool Board::is_attacked(int idx, bool attacker_color) {
-    // first check for potential pawn attackers
-    // attacker color white, pawn must be white.
-    // lower left
-    if(attacker_color == WHITE && (this->board[idx-9]!=0xFF)
-            && (this->get_piece_color(idx-9)==WHITE) && (this->get_piece_type(idx-9)==PAWN)) {
-        return true;
+// pieces of color that are the only piece between
+// their king and an enemy slider, and thus may
+// only move along that line
+Bitboard Board::pinned_pieces(int king_sq, bool color) const {
+
+    Bitboard pinned = 0;
+    Bitboard occupied = this->bb_color[WHITE] | this->bb_color[BLACK];
+    Bitboard queens = this->bb_piece[QUEEN];
+    Bitboard snipers = ((rook_attacks(king_sq, 0) & (this->bb_piece[ROOK] | queens))
+                        | (bishop_attacks(king_sq, 0) & (this->bb_piece[BISHOP] | queens)))
+            & this->bb_color[!color];
+    while(snipers) {
+        int sniper = pop_lsb(snipers);
+        Bitboard blockers = between(king_sq, sniper) & occupied;
+        if(blockers && !(blockers & (blockers - 1))) {
+            pinned |= blockers & this->bb_color[color];
+        }
     }
-    // lower right
-    if(attacker_color == WHITE && (this->board[idx-11]!=0xFF)
-            && (this->get_piece_color(idx-11)==WHITE) && (this->get_piece_type(idx-11)==PAWN)) {
-        return true;
+    return pinned;
+}
+
+void Board::generate_legal_moves(int from_square, int to_square, int piece_type, MoveList &moves) {
+
+    bool turn = this->turn;
+    Bitboard own = this->bb_color[turn];
+    Bitboard kings = own & this->bb_piece[KING];
+    // boards set up w/o king have no legal moves
+    if(!kings) {
+        return;
     }
-    // check black, upper right
-    if(attacker_color == BLACK && (this->board[idx+11]!=0xFF)
-            && (this->get_piece_color(idx+11)==BLACK) && (this->get_piece_type(idx+11)==PAWN)) {
-        return true;
+    int king_sq = lsb(kings);
+    Bitboard occupied = own | this->bb_color[!turn];
+    Bitboard checkers = this->attackers_to(king_sq, !turn, occupied);
+    Bitboard pinned = this->pinned_pieces(king_sq, turn);
+
+    Bitboard from_mask = BB_ALL;
+    if(from_square != ANY_SQUARE) {
+        from_mask = sq_bb(idx_to_sq(from_square));
     }
-    // check black, upper left
-    if(attacker_color == BLACK && (this->board[idx+9]!=0xFF)
-            && (this->get_piece_color(idx+9)==BLACK) && (this->get_piece_type(idx+9)==PAWN)) {
-        return true;
+    Bitboard to_mask = ~own;
+    if(to_square != ANY_SQUARE) {
+        to_mask &= sq_bb(idx_to_sq(to_square));
     }
-    // check all squares (except idx itself)
-    // for potential attackers
-    for(int i=21;i<99;i++) {
-        // skip empty squares
-        if(i!=idx && this->board[i] != 0x00) {  // ??? fringe??
-            // can't attack yourself
-            if(this->get_piece_color(i) == attacker_color) {
-                uint8_t piece = this->get_piece_type(i);
-                int distance = idx - i;
-                if(distance < 0) {
-                    distance = -distance;
+
+    // king moves: target must not be attacked once the
+    // king has left its square (sliders see through it)
+    if((piece_type == ANY_PIECE || piece_type == KING) && (kings & from_mask)) {
+        Bitboard targets = king_attacks(king_sq) & to_mask;
+        Bitboard occupied_wo_king = occupied & ~kings;
+        while(targets) {
+            int to = pop_lsb(targets);
+            if(!this->attackers_to(to, !turn, occupied_wo_king)) {
+                moves.add(king_sq,to);
+            }
+        }
+        // castling, if not in check and squares passed by king are not attacked
+        if(!checkers) {
+            if(turn == WHITE && king_sq == idx_to_sq(E1)) {
+                if(this->can_castle_wking() && this->board[H1] == WHITE_ROOK
+                        && this->is_empty(F1) && this->is_empty(G1)
+                        && (to_square == ANY_SQUARE || to_square == G1)
+                        && !this->is_attacked(F1,BLACK) && !this->is_attacked(G1,BLACK)) {
+                    moves.append(Move(E1,G1));
                 }
-                IntBits pot_attackers = IntBits(ATTACK_TABLE[distance]);
-                if((piece == KNIGHT && pot_attackers.test(0)) ||
-                        (piece == BISHOP && pot_attackers.test(1)) ||
-                        (piece == ROOK && pot_attackers.test(2)) ||
-                        (piece == QUEEN && pot_attackers.test(3)) ||
-                        (piece == KING && pot_attackers.test(4))) {
-                    // the target could be a potential attacker
-                    // now just get all pseudo legal moves from i,
-                    // excluding castling. If a move contains
-                    // target idx, then we have an attacker
-                    //QVector<Move> targets = this->pseudo_legal_moves_from(i,false,attacker_color);
-                    QVector<Move> targets =  this->pseudo_legal_moves(i, chess::ANY_SQUARE, chess::ANY_PIECE, false, attacker_color);
-                    for(int j=0;j<targets.size();j++) {
-                        //qDebug() << "is attacked psl: " << targets.at(j).uci();
-                        if(targets.at(j).to == idx) {
-                            return true;
-                        }
-                    }
+                if(this->can_castle_wqueen() && this->board[A1] == WHITE_ROOK
+                        && this->is_empty(D1) && this->is_empty(C1) && this->is_empty(B1)
+                        && (to_square == ANY_SQUARE || to_square == C1)
+                        && !this->is_attacked(D1,BLACK) && !this->is_attacked(C1,BLACK)) {
+                    moves.append(Move(E1,C1));
+                }
+            }
+            if(turn == BLACK && king_sq == idx_to_sq(E8)) {
+                if(this->can_castle_bking() && this->board[H8] == BLACK_ROOK
+                        && this->is_empty(F8) && this->is_empty(G8)
+                        && (to_square == ANY_SQUARE || to_square == G8)
+                        && !this->is_attacked(F8,WHITE) && !this->is_attacked(G8,WHITE)) {
+                    moves.append(Move(E8,G8));
+                }
+                if(this->can_castle_bqueen() && this->board[A8] == BLACK_ROOK
+                        && this->is_empty(D8) && this->is_empty(C8) && this->is_empty(B8)
+                        && (to_square == ANY_SQUARE || to_square == C8)
+                        && !this->is_attacked(D8,WHITE) && !this->is_attacked(C8,WHITE)) {
+                    moves.append(Move(E8,C8));
                 }
             }
         }
     }
-    return false;
-}
-
-
-QVector<Move> Board::pseudo_legal_moves(int from_square, int to_square,
-                                        int piece_type, bool generate_castles, bool turn)
-{
+    // in double check only the king may move
+    if(checkers & (checkers - 1)) {
+        return;
+    }
+    // in single check, other pieces must capture
+    // the checker or block the checking line
+    if(checkers) {
+        to_mask &= checkers | between(king_sq, lsb(checkers));
+    }
 
-    //qDebug() << "psl";
-    QVector<Move> moves;
     // pawn moves
     if(piece_type == ANY_PIECE || piece_type == PAWN) {
-        for(int i=0;i<10;i++) {
-            int from = this->piece_list[turn][PAWN][i];
-            if(from == EMPTY) {
-                break;
-            }
-            // skip if we generate only moves from a certain square
-            if(from_square != ANY_SQUARE && from_square != from) {
-                continue;
-            }
-            int piece_idx = IDX_WPAWN;
-            if(turn == BLACK) {
-                piece_idx = IDX_BPAWN;
-            }
-            // take up right, or up left
-            for(int j=3;j<=4;j++) {
-                int idx = from + DIR_TABLE[piece_idx][j];
-                if((to_square == ANY_SQUARE || idx == to_square) && !this->is_offside(idx)) {
-                    if((!this->is_empty(idx) && turn==BLACK && this->is_white_at(idx)) ||
-                            (!this->is_empty(idx) && turn==WHITE && !this->is_white_at(idx))) {
-                        // if it's a promotion square, add four moves
-                        if((turn==WHITE && (idx / 10 == 9)) || (turn==BLACK && (idx / 10 == 2))) {
-                            //qDebug() << "pawn take, promotion: " << from << " "  << idx;
-                            assert(this->board[from] != 0xff);
-                            moves.append(Move(from,idx,QUEEN));
-                            moves.append(Move(from,idx,ROOK));
-                            moves.append(Move(from,idx,BISHOP));
-                            moves.append(Move(from,idx,KNIGHT));
-                        } else {
-                            assert(this->board[from] != 0xff);
-                            /*
-                            qDebug() << "pawn take: " << from << " "  << idx;
-                            qDebug() << "is white at: " << +(this->is_white_at(idx));
-                            qDebug() << "content at: " << this->board[idx];
-*/
-                            moves.append(Move(from,idx));
-                        }
-                    }
-                }
-            }
-            // move one (j=1) or two (j=2) up (or down in the case of black)
-            int idx_1up = from + DIR_TABLE[piece_idx][1];
-            int idx_2up = from + DIR_TABLE[piece_idx][2];
-            if((to_square == ANY_SQUARE || idx_2up == to_square) && !this->is_offside(idx_2up)) {
-                if((turn == WHITE && (from/10==3)) || (turn==BLACK && (from/10==8))) {
-                    // means we have a white/black pawn in inital position, direct square
-                    // in front is empty => allow to move two forward
-                    if(this->is_empty(idx_1up) && this->is_empty(idx_2up)) {
-                        assert(this->board[from] != 0xff);
-                        //qDebug() << "pawn move, 2up: " << from << " "  << idx_2up;
-                        moves.append(Move(from,idx_2up));
+        Bitboard pawns = own & this->bb_piece[PAWN] & from_mask;
+        int up = 8;
+        Bitboard start_rank = BB_RANK_2;
+        Bitboard promotion_rank = BB_RANK_8;
+        if(turn == BLACK) {
+            up = -8;
+            start_rank = BB_RANK_7;
+            promotion_rank = BB_RANK_1;
+        }
+        int ep_sq = -1;
+        if(this->en_passent_target != 0) {
+            ep_sq = idx_to_sq(this->en_passent_target);
+        }
+        while(pawns) {
+            int from = pop_lsb(pawns);
+            Bitboard allowed = to_mask;
+            if(pinned & sq_bb(from)) {
+                allowed &= line(king_sq, from);
+            }
+            Bitboard targets = pawn_attacks(turn, from) & this->bb_color[!turn] & allowed;
+            int sq_1up = from + up;
+            if(sq_1up >= 0 && sq_1up < 64 && !(occupied & sq_bb(sq_1up))) {
+                targets |= sq_bb(sq_1up) & allowed;
+                if(start_rank & sq_bb(from)) {
+                    int sq_2up = sq_1up + up;
+                    if(!(occupied & sq_bb(sq_2up))) {
+                        targets |= sq_bb(sq_2up) & allowed;
                     }
                 }
             }
-            if((to_square == ANY_SQUARE || idx_1up == to_square) && !this->is_offside(idx_1up) && this->is_empty(idx_1up)) {
-                // if it's a promotion square, add four moves
-                if((turn==WHITE && (idx_1up / 10 == 9)) || (turn==BLACK && (idx_1up / 10 == 2))) {
-                    assert(this->board[from] != 0xff);
-                    //qDebug() << "pawn move, 1up, promotion: " << from << " "  << idx_1up;
-                    moves.append(Move(from,idx_1up,QUEEN));
-                    moves.append(Move(from,idx_1up,ROOK));
-                    moves.append(Move(from,idx_1up,BISHOP));
-                    moves.append(Move(from,idx_1up,KNIGHT));
+            while(targets) {
+                int to = pop_lsb(targets);
+                if(promotion_rank & sq_bb(to)) {
+                    moves.add(from,to,QUEEN);
+                    moves.add(from,to,ROOK);
+                    moves.add(from,to,BISHOP);
+                    moves.add(from,to,KNIGHT);
                 } else {
-                    assert(this->board[from] != 0xff);
-                    //qDebug() << "pawn move, 1up: " << from << " "  << idx_2up;
-                    moves.append(Move(from,idx_1up));
+                    moves.add(from,to);
                 }
             }
-            // finally, potential en-passent capture is handled
-            // left up
-            if(to_square == ANY_SQUARE || to_square == this->en_passent_target) {
-                if(turn == WHITE && (this->en_passent_target - from)==9) {
-                    assert(this->board[from] != 0xff);
-                    Move m = (Move(from,this->en_passent_target));
-                    moves.append(m);
-                }
-                // right up
-                if(turn == WHITE && (this->en_passent_target - from)==11) {
-                    assert(this->board[from] != 0xff);
-                    Move m = (Move(from,this->en_passent_target));
-                    moves.append(m);
-                }
-                // left down
-                if(turn == BLACK && (this->en_passent_target - from)==-9) {
-                    assert(this->board[from] != 0xff);
-                    Move m = (Move(from,this->en_passent_target));
-                    moves.append(m);
-                }
-                if(turn == BLACK && (this->en_passent_target - from)==-11) {
-                    assert(this->board[from] != 0xff);
-                    Move m = (Move(from,this->en_passent_target));
-                    moves.append(m);
+            // en passent removes two pieces from the board at once,
+            // so pin and check masks don't suffice. just test
+            // the occupancy after the capture directly
+            if(ep_sq >= 0 && (pawn_attacks(turn, from) & sq_bb(ep_sq))
+                    && (to_square == ANY_SQUARE || to_square == this->en_passent_target)) {
+                Bitboard victim = sq_bb(ep_sq - up);
+                Bitboard occ_after = (occupied & ~sq_bb(from) & ~victim) | sq_bb(ep_sq);
+                if(!(this->attackers_to(king_sq, !turn, occ_after) & ~victim)) {
+                    moves.add(from,ep_sq);
                 }
             }
         }
     }
-    if(piece_type == ANY_PIECE || piece_type == KNIGHT) {
-        for(int i=0;i<10;i++) {
-            int from = this->piece_list[turn][KNIGHT][i];
-            //qDebug() << "knight from: " << from;
-            if(from == EMPTY) {
-                break;
-            }
-            assert(this->board[from] != 0xff);
-            int lookup_idx = IDX_KNIGHT;
-            for(int j=1;j<=DIR_TABLE[lookup_idx][0];j++) {
-                int idx = from + DIR_TABLE[lookup_idx][j];
-                if((to_square == ANY_SQUARE || idx == to_square) && !this->is_offside(idx)) {
-                    if(this->is_empty(idx) ||
-                            (this->get_piece_color(idx) != turn)) {
-                        moves.append(Move(from,idx));
-                    }
-                }
-            }
+    // all other pieces
+    for(int pt=KNIGHT;pt<=QUEEN;pt++) {
+        if(piece_type != ANY_PIECE && piece_type != pt) {
+            continue;
         }
-    }
-    if(piece_type == ANY_PIECE || piece_type == KING) {
-        for(int i=0;i<10;i++) {
-            int from = this->piece_list[turn][KING][i];
-            if(from == EMPTY) {
+        Bitboard pieces = own & this->bb_piece[pt] & from_mask;
+        while(pieces) {
+            int from = pop_lsb(pieces);
+            Bitboard targets = 0;
+            switch(pt) {
+            case KNIGHT:
+                targets = knight_attacks(from);
+                break;
+            case BISHOP:
+                targets = bishop_attacks(from, occupied);
+                break;
+            case ROOK:
+                targets = rook_attacks(from, occupied);
+                break;
+            case QUEEN:
+                targets = queen_attacks(from, occupied);
                 break;
             }
-            assert(this->board[from] != 0xff);
-            int lookup_idx = IDX_KING;
-            for(int j=1;j<=DIR_TABLE[lookup_idx][0];j++) {
-                int idx = from + DIR_TABLE[lookup_idx][j];
-                if((to_square == ANY_SQUARE || idx == to_square) && !this->is_offside(idx)) {
-                    if(this->is_empty(idx) ||
-                            (this->get_piece_color(idx) != turn)) {
-                        moves.append(Move(from,idx));
-                    }
-                }
+            targets &= to_mask;
+            if(pinned & sq_bb(from)) {
+                targets &= line(king_sq, from);
+            }
+            while(targets) {
+                moves.add(from,pop_lsb(targets));
             }
         }
     }
-    if(piece_type == ANY_PIECE || piece_type == ROOK) {
-        for(int i=0;i<10;i++) {
-            int from = this->piece_list[turn][ROOK][i];
-            if(from == EMPTY) {
-                break;
-            }
-            assert(this->board[from] != 0xff);
-            int lookup_idx = IDX_ROOK;
-            for(int j=1;j<=DIR_TABLE[lookup_idx][0] ;j++) {
-                int idx = from + DIR_TABLE[lookup_idx][j];
-                bool stop = false;
-                while(!stop) {
-                    if(!this->is_offside(idx)) {
-                        if(this->is_empty(idx)) {
-                            if(to_square == ANY_SQUARE || to_square == idx) {
-                                moves.append(Move(from,idx));
-                            }
-                        } else {
-                            stop = true;
-                            if(this->get_piece_color(idx) != turn) {
-                                if(to_square == ANY_SQUARE || to_square == idx) {
-                                    moves.append(Move(from,idx));
-                                }
-                            }
-                        }
-                        idx = idx + DIR_TABLE[lookup_idx][j];
-                    } else {
-                        stop = true;
+}
+
+// instead of searching for pieces that attack sq,
+// look from sq outward: a piece of type p attacks sq
+// iff a piece of type p placed on sq would attack it.
+// for pawns, the direction has to be reversed, i.e.
+// we use the attacks of a pawn of the other color
+Bitboard Board::attackers_to(int sq, bool attacker_color, Bitboard occupied) const {
+    Bitboard queens = this->bb_piece[QUEEN];
+    Bitboard attackers = (pawn_attacks(!attacker_color, sq) & this->bb_piece[PAWN])
+            | (knight_attacks(sq) & this->bb_piece[KNIGHT])
+            | (king_attacks(sq) & this->bb_piece[KING])
+            | (bishop_attacks(sq, occupied) & (this->bb_piece[BISHOP] | queens))
+            | (rook_attacks(sq, occupied) & (this->bb_piece[ROOK] | queens));
+    return attackers & this->bb_color[attacker_color];
+}
+
+bool Board::is_attacked(int idx, bool attacker_color) const {
+    Bitboard occupied = this->bb_color[WHITE] | this->bb_color[BLACK];
+    return this->attackers_to(idx_to_sq(idx), attacker_color, occupied) != 0;
+}
+
+
+MoveList Board::pseudo_legal_moves(int from_square, int to_square,
+                                        int piece_type, bool generate_castles, bool turn)
+{
+
+    MoveList moves;
+    Bitboard own = this->bb_color[turn];
+    Bitboard occupied = own | this->bb_color[!turn];
+    // restrict sources and targets, if requested
+    Bitboard from_mask = BB_ALL;
+    if(from_square != ANY_SQUARE) {
+        from_mask = sq_bb(idx_to_sq(from_square));
+    }
+    Bitboard to_mask = ~own;
+    if(to_square != ANY_SQUARE) {
+        to_mask &= sq_bb(idx_to_sq(to_square));
+    }
+    // pawn moves
+    if(piece_type == ANY_PIECE || piece_type == PAWN) {
+        Bitboard pawns = own & this->bb_piece[PAWN] & from_mask;
+        int up = 8;
+        Bitboard start_rank = BB_RANK_2;
+        Bitboard promotion_rank = BB_RANK_8;
+        if(turn == BLACK) {
+            up = -8;
+            start_rank = BB_RANK_7;
+            promotion_rank = BB_RANK_1;
+        }
+        Bitboard ep_target = 0;
+        if(this->en_passent_target != 0) {
+            ep_target = sq_bb(idx_to_sq(this->en_passent_target)) & to_mask;
+        }
+        while(pawns) {
+            int from = pop_lsb(pawns);
+            // take up right, or up left
+            Bitboard targets = pawn_attacks(turn, from) & this->bb_color[!turn] & to_mask;
+            // move one or two up (or down in the case of black)
+            int sq_1up = from + up;
+            if(sq_1up >= 0 && sq_1up < 64 && !(occupied & sq_bb(sq_1up))) {
+                targets |= sq_bb(sq_1up) & to_mask;
+                // means we have a white/black pawn in inital position, direct square
+                // in front is empty => allow to move two forward
+                if(start_rank & sq_bb(from)) {
+                    int sq_2up = sq_1up + up;
+                    if(!(occupied & sq_bb(sq_2up))) {
+                        targets |= sq_bb(sq_2up) & to_mask;
                     }
                 }
             }
-        }
-    }
-    if(piece_type == ANY_PIECE || piece_type == BISHOP) {
-        for(int i=0;i<10;i++) {
-            int from = this->piece_list[turn][BISHOP][i];
-            if(from == EMPTY) {
-                break;
-            }
-            assert(this->board[from] != 0xff);
-            int lookup_idx = IDX_BISHOP;
-            for(int j=1;j<=DIR_TABLE[lookup_idx][0] ;j++) {
-                int idx = from + DIR_TABLE[lookup_idx][j];
-                bool stop = false;
-                while(!stop) {
-                    if(!this->is_offside(idx)) {
-                        if(this->is_empty(idx)) {
-                            if(to_square == ANY_SQUARE || to_square == idx) {
-                                moves.append(Move(from,idx));
-                            }
-                        } else {
-                            stop = true;
-                            if(this->get_piece_color(idx) != turn) {
-                                if(to_square == ANY_SQUARE || to_square == idx) {
-                                    moves.append(Move(from,idx));
-                                }
-                            }
-                        }
-                        idx = idx + DIR_TABLE[lookup_idx][j];
-                    } else {
-                        stop = true;
-                    }
+            while(targets) {
+                int to = pop_lsb(targets);
+                // if it's a promotion square, add four moves
+                if(promotion_rank & sq_bb(to)) {
+                    moves.add(from,to,QUEEN);
+                    moves.add(from,to,ROOK);
+                    moves.add(from,to,BISHOP);
+                    moves.add(from,to,KNIGHT);
+                } else {
+                    moves.add(from,to);
                 }
             }
+            // finally, potential en-passent capture is handled
+            if(pawn_attacks(turn, from) & ep_target) {
+                moves.add(from,idx_to_sq(this->en_passent_target));
+            }
         }
     }
-    if(piece_type == ANY_PIECE || piece_type == QUEEN) {
-        for(int i=0;i<10;i++) {
-            int from = this->piece_list[turn][QUEEN][i];
-            if(from == EMPTY) {
+    // all other pieces: lookup target squares
+    // and emit one move for each
+    for(int pt=KNIGHT;pt<=KING;pt++) {
+        if(piece_type != ANY_PIECE && piece_type != pt) {
+            continue;
+        }
+        Bitboard pieces = own & this->bb_piece[pt] & from_mask;
+        while(pieces) {
+            int from = pop_lsb(pieces);
+            Bitboard targets = 0;
+            switch(pt) {
+            case KNIGHT:
+                targets = knight_attacks(from);
+                break;
+            case BISHOP:
+                targets = bishop_attacks(from, occupied);
+                break;
+            case ROOK:
+                targets = rook_attacks(from, occupied);
+                break;
+            case QUEEN:
+                targets = queen_attacks(from, occupied);
+                break;
+            case KING:
+                targets = king_attacks(from);
                 break;
             }
-            assert(this->board[from] != 0xff);
-            int lookup_idx = IDX_QUEEN;
-            for(int j=1;j<=DIR_TABLE[lookup_idx][0] ;j++) {
-                int idx = from + DIR_TABLE[lookup_idx][j];
-                bool stop = false;
-                while(!stop) {
-                    if(!this->is_offside(idx)) {
-                        if(this->is_empty(idx)) {
-                            if(to_square == ANY_SQUARE || to_square == idx) {
-                                moves.append(Move(from,idx));
-                            }
-                        } else {
-                            stop = true;
-                            if(this->get_piece_color(idx) != turn) {
-                                if(to_square == ANY_SQUARE || to_square == idx) {
-                                    moves.append(Move(from,idx));
-                                }
-                            }
-                        }
-                        idx = idx + DIR_TABLE[lookup_idx][j];
-                    } else {
-                        stop = true;
-                    }
-                }
+            targets &= to_mask;
+            while(targets) {
+                moves.add(from,pop_lsb(targets));
             }
         }
     }
     if(generate_castles) {
-        if(turn == WHITE) {
+        if(turn == WHITE && (from_square == ANY_SQUARE || from_square == E1)) {
             // check for castling
             // white kingside
             if(!this->is_empty(E1) && this->can_castle_wking() &&
                     this->get_piece_color(E1) == WHITE && this->get_piece_color(H1) == WHITE
                     && this->get_piece_type(E1) == KING && this->get_piece_type(H1) == ROOK
-                    && this->is_empty(F1) && this->is_empty(G1)) {
+                    && this->is_empty(F1) && this->is_empty(G1)
+                    && (to_square == ANY_SQUARE || to_square == G1)) {
                 moves.append(Move(E1,G1));
             }
             // white queenside
             if(!this->is_empty(E1) && this->can_castle_wqueen() &&
                     this->get_piece_color(E1) == WHITE && this->get_piece_color(A1) == WHITE
                     && this->get_piece_type(E1) == KING && this->get_piece_type(A1) == ROOK
-                    && this->is_empty(D1) && this->is_empty(C1) && this->is_empty(B1)) {
+                    && this->is_empty(D1) && this->is_empty(C1) && this->is_empty(B1)
+                    && (to_square == ANY_SQUARE || to_square == C1)) {
                 moves.append(Move(E1,C1));
             }
         }
-        if(turn == BLACK) {
+        if(turn == BLACK && (from_square == ANY_SQUARE || from_square == E8)) {
             // black kingside
             if(!this->is_empty(E8) && this->can_castle_bking() &&
                     this->get_piece_color(E8) == BLACK && this->get_piece_color(H8) == BLACK
                     && this->get_piece_type(E8) == KING && this->get_piece_type(H8) == ROOK
-                    && this->is_empty(F8) && this->is_empty(G8)) {
+                    && this->is_empty(F8) && this->is_empty(G8)
+                    && (to_square == ANY_SQUARE || to_square == G8)) {
                 moves.append(Move(E8,G8));
             }
             // black queenside
             if(!this->is_empty(E8) && this->can_castle_bqueen() &&
                     this->get_piece_color(E8) == BLACK && this->get_piece_color(A8) == BLACK
                     && this->get_piece_type(E8) == KING && this->get_piece_type(A8) == ROOK
-                    && this->is_empty(D8) && this->is_empty(C8) && this->is_empty(B8)) {
+                    && this->is_empty(D8) && this->is_empty(C8) && this->is_empty(B8)
+                    && (to_square == ANY_SQUARE || to_square == C8)) {
                 moves.append(Move(E8,C8));
             }
         }
     }
-    //qDebug() << "psl fin";
-    //for(const Move mi: moves) {
-    //    qDebug() << "psl: " << mi.uci();
-    //}
     return moves;
 
 }
@@ -1245,82 +1274,86 @@ bool Board::is_white_at(int idx) const {
     }
 }
 
-void Board::remove_from_piece_list(bool color, int piece_type, int idx) {
+// polyglot orders pieces as black pawn, white pawn, black knight, ...
+// and squares as 8 * row + col, which is the bitboard square
+inline int Board::zobrist_piece_offset(bool color, int piece_type, int sq) const {
+    int kind_of_piece = 2 * (piece_type - 1);
+    if(color == WHITE) {
+        kind_of_piece += 1;
+    }
+    return 64 * kind_of_piece + sq;
+}
+
+void Board::remove_from_bitboards(bool color, int piece_type, int idx) {
 
-    assert(piece_type >= 0 && piece_type < 7);
     assert(idx >= 21 && idx <= 98);
-    int j = -1;
-    for(int i=0;i<10;i++) {
-        if(this->piece_list[color][piece_type][i] == idx) {
-            j = i;
-            break;
-        }
-    }
-    if(j>=0) {
-        // move all other one step further
-        for(int i=j+1;i<10;i++) {
-            this->piece_list[color][piece_type][i-1] = this->piece_list[color][piece_type][i];
-        }
-        // empty last one in list
-        this->piece_list[color][piece_type][9] = EMPTY;
+    // piece types beyond KING (i.e. 0x07 via set_piece_at)
+    // are not tracked
+    if(piece_type >= PAWN && piece_type <= KING) {
+        int sq = idx_to_sq(idx);
+        Bitboard b = sq_bb(sq);
+        this->bb_color[color] &= ~b;
+        this->bb_piece[piece_type] &= ~b;
+        this->pos_hash ^= POLYGLOT_RANDOM_64[this->zobrist_piece_offset(color, piece_type, sq)];
     }
 }
 
-void Board::add_to_piece_list(bool color, int piece_type, int idx) {
+void Board::add_to_bitboards(bool color, int piece_type, int idx) {
 
-    assert(piece_type >= 0 && piece_type < 7);
     assert(idx >= 21 && idx <= 98);
-    for(int i=0;i<10;i++) {
-        if(this->piece_list[color][piece_type][i] == EMPTY) {
-            this->piece_list[color][piece_type][i] = idx;
-            break;
-        }
+    if(piece_type >= PAWN && piece_type <= KING) {
+        int sq = idx_to_sq(idx);
+        Bitboard b = sq_bb(sq);
+        this->bb_color[color] |= b;
+        this->bb_piece[piece_type] |= b;
+        this->pos_hash ^= POLYGLOT_RANDOM_64[this->zobrist_piece_offset(color, piece_type, sq)];
     }
 }
 
 // doesn't check legality
 void Board::apply(const Move &m) {
 
-    //qDebug() << "apply";
+    // remember everything that can't be reconstructed
+    // from the move itself, so that undo() can revert it
+    UndoInfo info;
+    info.move = m.pack();
+    info.captured_piece = EMPTY;
+    info.captured_square = m.to;
+    info.en_passent_target = this->en_passent_target;
+    info.halfmove_clock = this->halfmove_clock;
+    info.castle_wking_ok = this->castle_wking_ok;
+    info.castle_wqueen_ok = this->castle_wqueen_ok;
+    info.castle_bking_ok = this->castle_bking_ok;
+    info.castle_bqueen_ok = this->castle_bqueen_ok;
+    info.last_was_null = this->last_was_null;
     if(m.is_null) {
         this->turn = !this->turn;
-        this->prev_en_passent_target = this->en_passent_target;
         this->en_passent_target = 0;
         this->last_was_null = true;
-        this->undo_available = true;
         if(this->turn == WHITE) {
             this->fullmove_number++;
         }
     } else {
-        //qDebug() << "apply else";
         this->last_was_null = false;
     this->turn = !this->turn;
-    this->prev_en_passent_target = this->en_passent_target;
-    this->prev_castle_wking_ok = this->castle_wking_ok;
-    this->prev_castle_wqueen_ok = this->castle_wqueen_ok;
-    this->prev_castle_bking_ok = this->castle_bking_ok;
-    this->prev_castle_bqueen_ok = this->castle_bqueen_ok;
     this->en_passent_target = 0;
     if(this->turn == WHITE) {
         this->fullmove_number++;
     }
-    for(int i=0;i<120;i++) {
-        this->old_board[i] = this->board[i];
-    }
 
     int old_piece_type = this->get_piece_type(m.from);
     bool color = this->get_piece_color(m.from);
-    // if target field is not empty, remove from piece list
+    // if target field is not empty, remove from bitboards
     // this must be of oppsite color than the currently moving piece
     if(this->board[m.to] != EMPTY) {
         int current_target_piece = this->get_piece_type(m.to);
-        this->remove_from_piece_list(!color, current_target_piece, m.to);
+        this->remove_from_bitboards(!color, current_target_piece, m.to);
+        info.captured_piece = this->board[m.to];
     }
-    // also remove the currently moving piece from the list
-    this->remove_from_piece_list(color, old_piece_type, m.from);
+    // also remove the currently moving piece from the bitboards
+    this->remove_from_bitboards(color, old_piece_type, m.from);
     // increase halfmove clock only if no capture or pawn advance
     // happend
-    this->prev_halfmove_clock = this->halfmove_clock;
     if(old_piece_type == PAWN || this->board[m.to] != EMPTY) {
         this->halfmove_clock = 0;
     } else {
@@ -1350,13 +1383,17 @@ void Board::apply(const Move &m) {
         if(this->board[m.to] == EMPTY) {
             if(color == WHITE && ((m.to-m.from == 9) || (m.to-m.from)==11)) {
                 // remove captured pawn
+                info.captured_piece = this->board[m.to-10];
+                info.captured_square = m.to-10;
                 this->board[m.to-10] = EMPTY;
-                this->remove_from_piece_list(BLACK, PAWN, m.to-10);
+                this->remove_from_bitboards(BLACK, PAWN, m.to-10);
             }
             if(color == BLACK && ((m.from -m.to == 9) || (m.from - m.to)==11)) {
                 // remove captured pawn
+                info.captured_piece = this->board[m.to+10];
+                info.captured_square = m.to+10;
                 this->board[m.to+10] = EMPTY;
-                this->remove_from_piece_list(WHITE, PAWN, m.to+10);
+                this->remove_from_bitboards(WHITE, PAWN, m.to+10);
             }
         }
     }
@@ -1367,18 +1404,16 @@ void Board::apply(const Move &m) {
         if(color == BLACK) {
             // +128 sets 7th bit to true (means black)            
             this->board[m.to] = m.promotion_piece +128;
-            // add to piece list
-            this->add_to_piece_list(BLACK, m.promotion_piece, m.to);
+            this->add_to_bitboards(BLACK, m.promotion_piece, m.to);
         }
         else {
             this->board[m.to] = m.promotion_piece;
-            this->add_to_piece_list(WHITE, m.promotion_piece, m.to);
+            this->add_to_bitboards(WHITE, m.promotion_piece, m.to);
         }
     } else {
         // otherwise the target is the piece on the from field
         this->board[m.to] = this->board[m.from];
-        // add to piece list
-        this->add_to_piece_list(color, old_piece_type, m.to);
+        this->add_to_bitboards(color, old_piece_type, m.to);
     }
     this->board[m.from] = EMPTY;
     // check if the move is castles, i.e. 0-0 or 0-0-0
@@ -1390,16 +1425,16 @@ void Board::apply(const Move &m) {
                 this->board[F1] = this->board[H1];
                 this->board[H1] = EMPTY;
                 this->set_castle_wking(false);
-                this->remove_from_piece_list(WHITE, ROOK, H1);
-                this->add_to_piece_list(WHITE, ROOK, F1);
+                this->remove_from_bitboards(WHITE, ROOK, H1);
+                this->add_to_bitboards(WHITE, ROOK, F1);
             }
             // white queenside
             if(m.from == E1 && m.to == C1) {
                 this->board[D1] = this->board[A1];
                 this->board[A1] = EMPTY;
                 this->set_castle_wqueen(false);
-                this->remove_from_piece_list(WHITE, ROOK, A1);
-                this->add_to_piece_list(WHITE, ROOK, D1);
+                this->remove_from_bitboards(WHITE, ROOK, A1);
+                this->add_to_bitboards(WHITE, ROOK, D1);
             } }
         else if(color==BLACK) {
             // black kingside
@@ -1407,16 +1442,16 @@ void Board::apply(const Move &m) {
                 this->board[F8] = this->board[H8];
                 this->board[H8] = EMPTY;
                 this->set_castle_bking(false);
-                this->remove_from_piece_list(BLACK, ROOK, H8);
-                this->add_to_piece_list(BLACK, ROOK, F8);
+                this->remove_from_bitboards(BLACK, ROOK, H8);
+                this->add_to_bitboards(BLACK, ROOK, F8);
             }
             // black queenside
             if(m.from == E8 && m.to == C8) {
                 this->board[D8] = this->board[A8];
                 this->board[A8] = EMPTY;
                 this->set_castle_bqueen(false);
-                this->remove_from_piece_list(BLACK, ROOK, A8);
-                this->add_to_piece_list(BLACK, ROOK, D8);
+                this->remove_from_bitboards(BLACK, ROOK, A8);
+                this->add_to_bitboards(BLACK, ROOK, D8);
             }
         }
     }
@@ -1479,133 +1514,141 @@ void Board::apply(const Move &m) {
             this->set_castle_wqueen(false);
         }
     }
-    // after move is applied, can revert to the previous position
-    this->undo_available = true;
     }
-    //qDebug() << "apply fin";
+    // after move is applied, can revert to the previous position
+    this->history.append(info);
 }
 
 void Board::undo() {
-    //qDebug() << "undo";
-    if(!this->undo_available) {
+    if(this->history.isEmpty()) {
         throw std::logic_error("must call board.apply(move) each time before calling undo() ");
-    } else {
-        if(this->last_was_null) {
-            this->turn = !this->turn;
-            this->en_passent_target = this->prev_en_passent_target;
-            this->prev_en_passent_target = 0;
-            this->last_was_null = false;
-            this->undo_available = true;
-        } else {
-            for(int i=0;i<120;i++) {
-                this->board[i] = this->old_board[i];
+    }
+    const UndoInfo info = this->history.last();
+    this->history.removeLast();
+    const Move m = Move::unpack(info.move);
+    this->turn = !this->turn;
+    if(this->turn == BLACK) {
+        this->fullmove_number--;
+    }
+    if(!m.is_null) {
+        bool color = this->turn;
+        // move the piece back. a promoted piece
+        // becomes a pawn again
+        int piece = this->board[m.to];
+        this->remove_from_bitboards(color, this->get_piece_type(m.to), m.to);
+        if(m.promotion_piece != EMPTY) {
+            piece = WHITE_PAWN;
+            if(color == BLACK) {
+                piece += 0x80;
+            }
+        }
+        this->board[m.to] = EMPTY;
+        this->board[m.from] = piece;
+        this->add_to_bitboards(color, this->get_piece_type(m.from), m.from);
+        // restore captured piece, which stands
+        // next to the target in case of en passent
+        if(info.captured_piece != EMPTY) {
+            this->board[info.captured_square] = info.captured_piece;
+            this->add_to_bitboards(!color, this->get_piece_type(info.captured_square), info.captured_square);
+        }
+        // move back rook when castling
+        if(this->get_piece_type(m.from) == KING) {
+            int rook_from = 0;
+            int rook_to = 0;
+            if(m.from == E1 && m.to == G1) {
+                rook_from = H1;
+                rook_to = F1;
+            } else if(m.from == E1 && m.to == C1) {
+                rook_from = A1;
+                rook_to = D1;
+            } else if(m.from == E8 && m.to == G8) {
+                rook_from = H8;
+                rook_to = F8;
+            } else if(m.from == E8 && m.to == C8) {
+                rook_from = A8;
+                rook_to = D8;
             }
-            this->undo_available = false;
-            this->en_passent_target = this->prev_en_passent_target;
-            this->prev_en_passent_target = 0;
-            this->castle_wking_ok = this->prev_castle_wking_ok;
-            this->castle_wqueen_ok = this->prev_castle_wqueen_ok;
-            this->castle_bking_ok = this->prev_castle_bking_ok;
-            this->castle_bqueen_ok = this->prev_castle_bqueen_ok;
-            this->turn = !this->turn;
-            this->halfmove_clock = this->prev_halfmove_clock;
-            this->prev_halfmove_clock = 0;
-            if(this->turn == BLACK) {
-                this->fullmove_number--;
+            if(rook_from != 0) {
+                this->board[rook_from] = this->board[rook_to];
+                this->board[rook_to] = EMPTY;
+                this->remove_from_bitboards(color, ROOK, rook_to);
+                this->add_to_bitboards(color, ROOK, rook_from);
             }
         }
     }
-    this->init_piece_list();
-    //qDebug() << "undo fin";
+    this->en_passent_target = info.en_passent_target;
+    this->halfmove_clock = info.halfmove_clock;
+    this->castle_wking_ok = info.castle_wking_ok;
+    this->castle_wqueen_ok = info.castle_wqueen_ok;
+    this->castle_bking_ok = info.castle_bking_ok;
+    this->castle_bqueen_ok = info.castle_bqueen_ok;
+    this->last_was_null = info.last_was_null;
+}
+
+bool Board::is_undo_available() const {
+    return !this->history.isEmpty();
+}
+
+void Board::clear_history() {
+    this->history.clear();
 }
 
 
 Board::Board(const Board &other) {
-    turn = other.turn;
+    this->copy_position(other);
+    this->history = other.history;
+}
+
+void Board::copy_position(const Board &other) {
+    this->turn = other.turn;
     this->castle_wking_ok = other.castle_wking_ok;
     this->castle_wqueen_ok = other.castle_wqueen_ok;
     this->castle_bking_ok = other.castle_bking_ok;
     this->castle_bqueen_ok = other.castle_bqueen_ok;
-    this->prev_castle_wking_ok = other.prev_castle_wking_ok;
-    this->prev_castle_wqueen_ok = other.prev_castle_wqueen_ok;
-    this->prev_castle_bking_ok = other.prev_castle_bking_ok;
-    this->prev_castle_bqueen_ok = other.prev_castle_bqueen_ok;
     this->en_passent_target = other.en_passent_target;
     this->halfmove_clock = other.halfmove_clock;
     this->fullmove_number = other.fullmove_number;
-    this->undo_available = other.undo_available;
+    this->history.resize(0);
     this->last_was_null = other.last_was_null;
-    this->prev_halfmove_clock = other.prev_halfmove_clock;
-    this->zobrist_initialized = other.zobrist_initialized;
-    this->pos_hash_initialized = other.pos_hash_initialized;
-    this->zobrist = other.zobrist;
     this->pos_hash = other.pos_hash;
     for(int i=0;i<120;i++) {
         this->board[i] = other.board[i];
-        this->old_board[i] = other.old_board[i];
     }
+    this->bb_color[WHITE] = other.bb_color[WHITE];
+    this->bb_color[BLACK] = other.bb_color[BLACK];
     for(int i=0;i<7;i++) {
-        for(int j=0;j<10;j++) {
-            this->piece_list[WHITE][i][j] = other.piece_list[WHITE][i][j];
-            this->piece_list[BLACK][i][j] = other.piece_list[BLACK][i][j];
-        }
+        this->bb_piece[i] = other.bb_piece[i];
     }
 }
 
 bool Board::is_stalemate() {
-    // search for king of player with current turn
-    // check whether king is attacked
-    for(int i=21;i<99;i++) {
-        if((this->get_piece_type(i)==KING) && (this->get_piece_color(i)==this->turn)){
-            if(!this->is_attacked(i,!this->turn)) {
-                QVector<Move> legals = this->legal_moves();
-                int c = legals.count();
-                if(c==0) {
-                    return true;
-                } else {
-                    return false;
-                }
-            } else {
-                return false;
-            }
-        }
+    // king of player with current turn
+    // must not be attacked, and there must be
+    // no legal move
+    Bitboard kings = this->bb_color[this->turn] & this->bb_piece[KING];
+    if(!kings || this->is_check()) {
+        return false;
     }
-    return false;
+    return this->legal_moves().isEmpty();
 }
 
 
 bool Board::is_checkmate() {
-    // search for king of player with current turn
-    // check whether king is attacked
-    for(int i=21;i<99;i++) {
-        if((this->get_piece_type(i)==KING) && (this->get_piece_color(i)==this->turn)){
-            if(this->is_attacked(i,!this->turn)) {
-                QVector<Move> legals = this->legal_moves();
-                int c = legals.count();
-                if(c==0) {
-                    return true;
-                } else {
-                    return false;
-                }
-            } else {
-                return false;
-            }
-        }
+    // king of player with current turn
+    // must be attacked, and there must be
+    // no legal move
+    if(!this->is_check()) {
+        return false;
     }
-    return false;
+    return this->legal_moves().isEmpty();
 }
 
 bool Board::is_check() {
-    for(int i=21;i<99;i++) {
-        if((this->get_piece_type(i)==KING) && (this->get_piece_color(i)==this->turn)){
-            if(this->is_attacked(i,!this->turn)) {
-                return true;
-            } else {
-                return false;
-            }
-        }
+    Bitboard kings = this->bb_color[this->turn] & this->bb_piece[KING];
+    if(!kings) {
+        return false;
     }
-    return false;
+    return this->is_attacked(sq_to_idx(lsb(kings)), !this->turn);
 }
 
 
@@ -1665,16 +1708,10 @@ QString Board::san(const Move &m) {
 
     //qDebug() << "SAN 2";
     // first test for checkmate and check (to be appended later)
-    // create temp board, since appyling move and
-    // testing for checkmate (which again needs
-    // application of a move) makes it impossible
-    // to undo (undo can only be done once, not twice in a row)
-
-    //qDebug() << "SAN 3";
-    Board b_temp = Board(*this);
-    b_temp.apply(m);
-    bool is_check = b_temp.is_check();
-    bool is_checkmate = b_temp.is_checkmate();
+    this->apply(m);
+    bool is_check = this->is_check();
+    bool is_checkmate = this->is_checkmate();
+    this->undo();
 
     if(this->is_castles_wking(m) || this->is_castles_bking(m)) {
         san.append("O-O");
@@ -1713,8 +1750,8 @@ QString Board::san(const Move &m) {
         if(piece_type == KING) {
             san.append("K");
         }
-        QVector<Move> col_disambig;
-        QVector<Move> row_disambig;
+        MoveList col_disambig;
+        MoveList row_disambig;
         int this_row = (m.from / 10) - 1;
         int this_col = m.from % 10;
 
@@ -1724,18 +1761,18 @@ QString Board::san(const Move &m) {
             // if piece list contains only one piece, skip move generation
             // for testing disambiguity
             //qDebug() << "piece: " << piece;
-            if(this->piece_list[this->turn][piece_type][1] == EMPTY) {
+            if(popcount(this->bb_color[this->turn] & this->bb_piece[piece_type]) < 2) {
                 goto ambig_check_finished;
             }
             //qDebug() << "SAN 6a";
-            //QVector<Move> pseudo_legals = this->pseudo_legal_moves_from(m.from, false, this->turn);
-            QVector<Move> pseudo_legals = this->pseudo_legal_moves(chess::ANY_SQUARE, m.to, piece_type, false, this->turn);
+            //MoveList pseudo_legals = this->pseudo_legal_moves_from(m.from, false, this->turn);
+            MoveList pseudo_legals = this->pseudo_legal_moves(chess::ANY_SQUARE, m.to, piece_type, false, this->turn);
             //qDebug() << "SAN 6b";
             if(pseudo_legals.size() == 1) {
                 goto ambig_check_finished;
             }
             //qDebug() << "SAN 6c";
-            QVector<Move> legals = this->legals_from_pseudos(pseudo_legals);
+            MoveList legals = this->legals_from_pseudos(pseudo_legals);
             //qDebug() << "SAN 6d";
             if(legals.size() == 1) {
                 goto ambig_check_finished;
@@ -2109,118 +2146,58 @@ std::ostream& operator<<(std::ostream &strm, const Board &b) {
     return strm;
 }
 
-int Board::zobrist_piece_type(int piece) const {
-    switch (piece)
-    {
-        case BLACK_PAWN:
-            return 0;
-        case WHITE_PAWN:
-            return 1;
-        case BLACK_KNIGHT:
-            return 2;
-        case WHITE_KNIGHT:
-            return 3;
-        case BLACK_BISHOP:
-            return 4;
-        case WHITE_BISHOP:
-            return 5;
-        case BLACK_ROOK:
-            return 6;
-        case WHITE_ROOK:
-            return 7;
-        case BLACK_QUEEN:
-            return 8;
-        case WHITE_QUEEN:
-            return 9;
-        case BLACK_KING:
-            return 10;
-        case WHITE_KING:
-            return 11;
-    }
-    throw std::invalid_argument("piece type out of range in ZobristHash:kind_of_piece");
-}
-
-quint64 Board::get_pos_hash() {
-
-    if(this->pos_hash_initialized) {
-        return this->pos_hash;
-    } else {
-        quint64 piece = Q_UINT64_C(0);
-        for(int i=0;i<8;i++) {
-            for(int j=0;j<8;j++) {
-                uint8_t piece_at_ij = this->get_piece_at(i,j);
-                //qDebug() << i << j << " " <<  piece_at_ij;
-                if(piece_at_ij != EMPTY) {
-                    int kind_of_piece = this->zobrist_piece_type(piece_at_ij);
-                    int offset_piece = 64 * kind_of_piece + 8 * j + i;
-                    piece = piece^POLYGLOT_RANDOM_64[offset_piece];
-                }
-            }
-        }
-        this->pos_hash = piece;
-        return this->pos_hash;
-    }
+// pos_hash is updated whenever a piece is added to or
+// removed from the board (cf. add_to_bitboards), so
+// it is always current
+quint64 Board::get_pos_hash() const {
+    return this->pos_hash;
 }
 
-quint64 Board::get_zobrist() {
+// the zobrist key is the position hash plus keys for
+// castling rights, en passent and turn. these are
+// cheap to determine, so they are not stored
+quint64 Board::get_zobrist() const {
 
-    if(this->zobrist_initialized) {
-        return this->zobrist;
-    } else {
-        quint64 piece = Q_UINT64_C(0);
-        for(int i=0;i<8;i++) {
-            for(int j=0;j<8;j++) {
-                uint8_t piece_at_ij = this->get_piece_at(i,j);
-                if(piece_at_ij != EMPTY) {
-                    int kind_of_piece = this->zobrist_piece_type(piece_at_ij);
-                    int offset_piece = 64 * kind_of_piece + 8 * j + i;
-                    piece = piece^POLYGLOT_RANDOM_64[offset_piece];
-                }
+    quint64 piece = this->pos_hash;
+    quint64 en_passent = Q_UINT64_C(0);
+    uint8_t ep_target = this->get_ep_target();
+    if(ep_target != 0) {
+        int file = (ep_target % 10) - 1;
+        // check if left or right is a pawn from player to move
+        if(this->turn == WHITE) {
+            uint8_t left = this->get_piece_at(ep_target-11);
+            uint8_t right = this->get_piece_at(ep_target-9);
+            if(left == WHITE_PAWN || right == WHITE_PAWN) {
+                en_passent = POLYGLOT_RANDOM_64[RANDOM_EN_PASSENT + file];
             }
-        }
-        //std::cout << "pieces:" << std::endl;
-        //std::cout << std::hex << piece << std::endl;
-        quint64 en_passent = Q_UINT64_C(0);
-        uint8_t ep_target = this->get_ep_target();
-        if(ep_target != 0) {
-            int file = (ep_target % 10) - 1;
-            // check if left or right is a pawn from player to move
-            if(this->turn == WHITE) {
-                uint8_t left = this->get_piece_at(ep_target-11);
-                uint8_t right = this->get_piece_at(ep_target-9);
-                if(left == WHITE_PAWN || right == WHITE_PAWN) {
-                    en_passent = POLYGLOT_RANDOM_64[RANDOM_EN_PASSENT + file];
-                }
-            } else {
-                uint8_t left = this->get_piece_at(ep_target+11);
-                uint8_t right = this->get_piece_at(ep_target+9);
-                if(left == BLACK_PAWN || right == BLACK_PAWN) {
-                    en_passent = POLYGLOT_RANDOM_64[RANDOM_EN_PASSENT + file];
-                }
+        } else {
+            uint8_t left = this->get_piece_at(ep_target+11);
+            uint8_t right = this->get_piece_at(ep_target+9);
+            if(left == BLACK_PAWN || right == BLACK_PAWN) {
+                en_passent = POLYGLOT_RANDOM_64[RANDOM_EN_PASSENT + file];
             }
         }
-        quint64 castle = Q_UINT64_C(0);
-        if(this->can_castle_wking()) {
-            castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE];
-        }
-        if(this->can_castle_wqueen()) {
-            castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE+1];
-        }
-        if(this->can_castle_bking()) {
-            castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE+2];
-        }
-        if(this->can_castle_bqueen()) {
-            castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE+3];
-        }
-
-        quint64 turn = Q_UINT64_C(0);
-        if(this->turn == WHITE) {
-            turn = POLYGLOT_RANDOM_64[RANDOM_TURN];
-        }
+    }
+    quint64 castle = Q_UINT64_C(0);
+    if(this->can_castle_wking()) {
+        castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE];
+    }
+    if(this->can_castle_wqueen()) {
+        castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE+1];
+    }
+    if(this->can_castle_bking()) {
+        castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE+2];
+    }
+    if(this->can_castle_bqueen()) {
+        castle = castle^POLYGLOT_RANDOM_64[RANDOM_CASTLE+3];
+    }
 
-        this->zobrist = piece^castle^en_passent^turn;
-        return this->zobrist;
+    quint64 turn = Q_UINT64_C(0);
+    if(this->turn == WHITE) {
+        turn = POLYGLOT_RANDOM_64[RANDOM_TURN];
     }
+
+    return piece^castle^en_passent^turn;
 }
 
 
@@ -25,11 +25,33 @@
 #include <cstdint>
 #include <QRegularExpression>
 #include <QMap>
+#include <QVector>
 #include "constants.h"
+#include "bitboard.h"
 #include "move.h"
 
 namespace chess {
 
+/**
+ * @brief UndoInfo is the state that Board::apply() records for
+ *                 each move, so that undo() can revert it.
+ */
+struct UndoInfo
+{
+    // packed, see Move::pack()
+    quint16 move;
+    // piece removed by the move (EMPTY if none) and the square it
+    // stood on, which differs from move.to for en passent captures
+    int captured_piece;
+    int captured_square;
+    int en_passent_target;
+    int halfmove_clock;
+    bool castle_wking_ok;
+    bool castle_wqueen_ok;
+    bool castle_bking_ok;
+    bool castle_bqueen_ok;
+    bool last_was_null;
+};
 
 class Board
 {
@@ -101,21 +123,37 @@ public:
     void apply(const Move &m);
 
     /**
-     * @brief undo undoes the very last move. undoing can only be done once for the very
-     *             last move that was applied before, i.e. apply undo apply undo is ok,
-     *             but apply apply undo undo is not. throws logic error if called
-     *             in wrong fashion. check with is_undo_available() when in doubt
+     * @brief undo undoes the very last move. moves can be undone in reverse
+     *             order of application down to the position where the board
+     *             was created, i.e. apply apply undo undo is ok.
+     *             throws logic error if there is no move left to undo.
+     *             check with is_undo_available() when in doubt
      */
     void undo();
 
+    /**
+     * @brief clear_history forgets all applied moves, i.e. the current
+     *                      position can't be undone any further. Use for
+     *                      boards that are kept for a long time (e.g. in game trees)
+     */
+    void clear_history();
+
+    /**
+     * @brief copy_position sets this board to the position of other,
+     *                      without its history. The own history is cleared,
+     *                      but keeps its capacity, so that a board that is
+     *                      overwritten again and again does not allocate
+     */
+    void copy_position(const Board &other);
+
     /**
      * @brief pseudo_legal_moves returns move list with all pseudo-legal moves of
      *                           current position
      * @return
      */
-    QVector<Move> pseudo_legal_moves();
+    MoveList pseudo_legal_moves();
 
-    QVector<Move> pseudo_legal_moves(int to_square, int piece_type);
+    MoveList pseudo_legal_moves(int to_square, int piece_type);
 
     /**
      * @brief pseudo_legal_moves_from returns move list with pseudo legal moves
@@ -127,26 +165,44 @@ public:
      * @param turn_color              either WHITE or BLACK, i.e. the player to move
      * @return pseudo legal move list
      */
-    //QVector<Move> pseudo_legal_moves_from(int from_square_idx, bool with_castles, bool turn_color);
-    //QVector<Move> pseudo_legal_moves_to(int to_square, int piece_type, bool with_castles, bool turn);
+    //MoveList pseudo_legal_moves_from(int from_square_idx, bool with_castles, bool turn_color);
+    //MoveList pseudo_legal_moves_to(int to_square, int piece_type, bool with_castles, bool turn);
 
-    QVector<Move> pseudo_legal_moves(int from_square, int to_square, int piece_type, bool generate_castles, bool turn);
+    MoveList pseudo_legal_moves(int from_square, int to_square, int piece_type, bool generate_castles, bool turn);
 
     /**
      * @brief legal_moves returns move list of all legal moves in position
      * @return move list
      */
-    QVector<Move> legal_moves();
-    QVector<Move> legal_moves(int to_square, int piece_type);
+    MoveList legal_moves();
+    MoveList legal_moves(int to_square, int piece_type);
 
     /**
      * @brief legal_moves_from computes all legal moves originating in from square
      * @param from_square  move originates from this square. must be in range 21...98
      * @return move list of legal moves
      */
-    QVector<Move> legal_moves_from(int from_square);
+    MoveList legal_moves_from(int from_square);
 
-    QVector<Move> legals_from_pseudos(QVector<Move> &pseudos);
+    MoveList legals_from_pseudos(MoveList &pseudos);
+
+    /**
+     * @brief resolve_piece_move finds the move of a san token like Nf3, Rae1 or
+     *                           Q4h4 of the side to move. Instead of generating
+     *                           moves, the origin candidates are looked up
+     *                           backwards from the destination. Pins are only
+     *                           checked if more than one candidate is left.
+     * @param piece_type one of KNIGHT ... KING
+     * @param to_square internal index of the destination
+     * @param from_col column (0 ... 7) of the origin, or -1 if not given
+     * @param from_row row (0 ... 7) of the origin, or -1 if not given
+     * @param m is set to the move if there is exactly one
+     * @param trusted if true, the move is known to be legal, and candidates
+     *                are told apart by pins only, also if in check
+     * @return true if the san token denotes exactly one move
+     */
+    bool resolve_piece_move(int piece_type, int to_square, int from_col, int from_row, Move &m,
+                            bool trusted = false);
 
     /**
      * @brief pseudo_is_legal_move checks whether supplied pseudo legal move is legal
@@ -399,8 +455,19 @@ public:
 
     bool can_claim_fifty_moves() const;
 
-    quint64 get_zobrist();
-    quint64 get_pos_hash();
+    /**
+     * @brief get_zobrist returns the polyglot key of the position (pieces, castling
+     *                    rights, en passent and turn). constant time
+     * @return zobrist key
+     */
+    quint64 get_zobrist() const;
+
+    /**
+     * @brief get_pos_hash returns the polyglot key of the piece placement only,
+     *                     i.e. w/o castling rights, en passent and turn. constant time
+     * @return position hash
+     */
+    quint64 get_pos_hash() const;
 
     QString print_raw();
 
@@ -421,20 +488,26 @@ private:
     int board[120];
 
     /**
-     * @brief old_board stores the previous position for undo()
+     * @brief history stores one record per applied move for undo()
      */
-    int old_board[120];
+    QVector<UndoInfo> history;
 
-    int piece_list[2][7][10];
+    /**
+     * @brief bb_color occupancy of all WHITE resp. BLACK pieces.
+     *        kept in sync with board[] and used for move generation
+     */
+    Bitboard bb_color[2];
 
     /**
-     * @brief turn is either WHITE or BLACK
+     * @brief bb_piece occupancy per piece type (PAWN ... KING) of
+     *        both colors. index 0 is unused
      */
-    bool undo_available;
+    Bitboard bb_piece[7];
 
-    bool zobrist_initialized;
-    bool pos_hash_initialized;
-    quint64 zobrist;
+    /**
+     * @brief pos_hash polyglot key of the piece placement only,
+     *        updated incrementally whenever a piece is placed or removed
+     */
     quint64 pos_hash;
 
     /**
@@ -448,20 +521,34 @@ private:
     bool castle_bking_ok;
     bool castle_bqueen_ok;
 
-    bool prev_castle_wking_ok;
-    bool prev_castle_wqueen_ok;
-    bool prev_castle_bking_ok;
-    bool prev_castle_bqueen_ok;
-
     int en_passent_target;
-    int prev_en_passent_target;
-
-    int prev_halfmove_clock;
 
     bool is_empty(int idx) const;
     bool is_offside(int idx) const;
     bool is_white_at(int idx) const;
-    bool is_attacked(int idx, bool attacker_color);
+    bool is_attacked(int idx, bool attacker_color) const;
+    Bitboard pinned_pieces(int king_sq, bool color) const;
+
+    /**
+     * @brief generate_legal_moves appends all strictly legal moves of the
+     *                             side to move to moves. Filters as in
+     *                             pseudo_legal_moves(), castles are included
+     * @param from_square ANY_SQUARE or internal index of source field
+     * @param to_square ANY_SQUARE or internal index of target field
+     * @param piece_type ANY_PIECE or one of PAWN ... KING
+     * @param moves list to append to
+     */
+    void generate_legal_moves(int from_square, int to_square, int piece_type, MoveList &moves);
+
+    /**
+     * @brief attackers_to returns all pieces of attacker_color that attack
+     *                     the supplied square, given occupancy occupied
+     * @param sq bitboard square (0...63), not internal board index!
+     * @param attacker_color WHITE or BLACK
+     * @param occupied occupancy used for sliding pieces
+     * @return bitboard of attacking pieces
+     */
+    Bitboard attackers_to(int sq, bool attacker_color, Bitboard occupied) const;
     bool is_castles_wking(const Move &m) const;
     bool is_castles_bking(const Move &m) const;
     bool is_castles_wqueen(const Move &m) const;
@@ -470,12 +557,12 @@ private:
     QChar piece_to_symbol(int piece) const;
     QString idx_to_str(int idx) const;
 
-    void init_piece_list();
+    void init_occupancy();
 
-    int zobrist_piece_type(int piece) const;
+    int zobrist_piece_offset(bool color, int piece_type, int sq) const;
 
-    void remove_from_piece_list(bool color, int piece_type, int idx);
-    void add_to_piece_list(bool color, int piece_type, int idx);
+    void remove_from_bitboards(bool color, int piece_type, int idx);
+    void add_to_bitboards(bool color, int piece_type, int idx);
 
     friend std::ostream& operator<<(std::ostream& strm, const Board &b);
 
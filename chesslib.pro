@@ -23,15 +23,26 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        bitboard.cpp \
         board.cpp \
         ecocode.cpp \
         game.cpp \
+        game_db.cpp \
         game_node.cpp \
         gui_printer.cpp \
         main.cpp \
         move.cpp \
+        node_arena.cpp \
+        node_pool.cpp \
+        pgn_bulk_reader.cpp \
+        pgn_game_iterator.cpp \
+        pgn_header_table.cpp \
+        pgn_index.cpp \
         pgn_printer.cpp \
+        perft.cpp \
         pgn_reader.cpp \
+        pgn_scanner.cpp \
+        pgn_tag.cpp \
         polyglot.cpp \
     testcases.cpp
 
@@ -44,15 +55,26 @@ HEADERS += \
     constants.h \
     arrow.h \
     arrow.h \
+    bitboard.h \
     board.h \
     colored_field.h \
     constants.h \
     ecocode.h \
     game.h \
+    game_db.h \
     game_node.h \
     gui_printer.h \
     move.h \
+    node_arena.h \
+    node_pool.h \
+    perft.h \
+    pgn_bulk_reader.h \
+    pgn_game_iterator.h \
+    pgn_header_table.h \
+    pgn_index.h \
     pgn_printer.h \
     pgn_reader.h \
+    pgn_scanner.h \
+    pgn_tag.h \
     polyglot.h \
     testcases.h
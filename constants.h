@@ -310,57 +310,6 @@ const int INIT_POS[120] = {
     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
 };
 
-// attack table
-// the index of this array corresponds to the distance
-// between two squares of the board (note the board is
-// encoded as a one dim array of size 120, where A1 = 21, H1 = 28
-// A8 = 91, A8 = 98.
-// the value denotes whether an enemy rook, bishop, knight, queen, king
-// on one square can attack the other square. The following encoding
-// is used:
-// Bitposition    Piece
-// 0              Knight
-// 1              Bishop
-// 2              Rook
-// 3              Queen
-// 4              King
-// e.g. distance one, i.e. index 1 (=left, up, down, right square) has
-// value 0x1C = MSB 00011100 LSB, i.e. king, queen, rook can
-// potentially attack
-const uint8_t ATTACK_TABLE[78] = {
-    0x00, 0x1C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x01, 0x1a,
-    0x1C, 0x1A, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x01,
-    0x0C, 0x01, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00,
-    0x0C, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00,
-    0x0C, 0x00, 0x00, 0x00, 0x0A, 0x0a, 0x00, 0x00, 0x00, 0x00,
-    0x0C, 0x00, 0x00, 0x00, 0x0a, 0x0A, 0x00, 0x00, 0x00, 0x00,
-    0x0C, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00,
-    0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A
-};
-
-const int IDX_BPAWN = 0;
-const int IDX_WPAWN = 1;
-const int IDX_KNIGHT = 2;
-const int IDX_BISHOP = 3;
-const int IDX_ROOK = 4;
-const int IDX_QUEEN = 5;
-const int IDX_KING = 6;
-
-// first dim is for different piece types
-// [piece_type[0] is DCOUNT (as in Byte Magazine paper)
-// [piece_type[1] ... [piece_type][4] resp.
-// [piece_type[1] ... [piece_type][8] contain
-// DPOINT table
-const int DIR_TABLE[7][9] = {
-    { 4, -10, -20, -11, -9 ,   0,   0,   0,   0 }, // max 4 black pawn directions, rest 0's
-    { 4, +10, +20, +11, +9 ,   0,   0,   0,   0 }, // max 4 white pawn directions, rest 0's
-    { 8, -21, -12, +8 , +19, +21, +12, -8, -19 }, // 8 knight directions
-    { 4, +9 , +11, -11, -9 ,   0,   0,   0,   0 }, // 4 bishop directions
-    { 4, +10, -10, +1 , -1 ,   0,   0,   0,   0 }, // 4 rook directions
-    { 8, +9 , +11, -11, -9 ,   +10, -10, +1, -1 }, // 8 queen directions
-    { 8, +9 , +11, -11, -9 ,   +10, -10, +1, -1 }  // 8 king directions (= queen dir's)
-};
-
 // players
 const bool WHITE = false;
 const bool BLACK = true;
@@ -491,7 +440,6 @@ const int RES_DRAW = 3;
 const int RES_ANY = 4;
 
 // PGN READING & WRITING
-const QRegularExpression TAG_REGEX = QRegularExpression("\\[([A-Za-z0-9]+)\\s+\"(.*)\"\\]");
 
 const int NAG_NULL = 0;
 
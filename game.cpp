@@ -26,20 +26,84 @@ namespace chess {
 
 Game::Game() {
 
-    this->root = new GameNode();
-    //this->root = NodePool::makeNode();
+    this->root = this->createInitialRoot();
     this->result = RES_UNDEF;
     this->current = root;
     this->treeWasChanged = false;
+    this->checkpointInterval = 0;
 
     this->wasEcoClassified = false;
+    this->rawHeadersUtf8 = true;
     //this->ecoInfo("","");
 
 }
 
 Game::~Game() {
-    this->delBelow(this->root);
-    delete this->root;
+    // all nodes are released by the arena
+}
+
+GameNode* Game::createNode() {
+    return this->arena.create();
+}
+
+GameNode* Game::createChild(GameNode *parent, const Move &m) {
+    GameNode *child = this->createNode();
+    child->m = m;
+    parent->addVariation(child);
+    int distance = 0;
+    if(this->checkpointInterval > 0) {
+        distance = parent->checkpointDistance + 1;
+        if(distance >= this->checkpointInterval) {
+            distance = 0;
+        }
+    }
+    child->checkpointDistance = distance;
+    Board *b_parent = parent->getBoard();
+    if(parent->checkpointDistance > 0) {
+        // parent's board is just cached, and can be
+        // reconstructed. move it down instead of copying
+        child->board = b_parent;
+        parent->board = nullptr;
+        child->board->clear_history();
+    } else if(child->spareBoard != nullptr) {
+        // recycled nodes reuse the memory of their former board
+        child->board = child->allocBoard();
+        child->board->copy_position(*b_parent);
+    } else {
+        child->board = new Board(*b_parent);
+        child->board->clear_history();
+    }
+    // keep only the move leading to this node as history,
+    // otherwise boards grow with the length of the game
+    child->board->apply(m);
+    child->posHash = child->board->get_pos_hash();
+    return child;
+}
+
+void Game::setCheckpointInterval(int n) {
+    this->checkpointInterval = qMax(0, n);
+}
+
+int Game::getCheckpointInterval() {
+    return this->checkpointInterval;
+}
+
+void Game::releaseBoards() {
+    this->releaseBoardsRec(this->getRootNode());
+}
+
+void Game::releaseBoardsRec(GameNode *node) {
+    node->releaseBoard();
+    for(int i=0;i<node->variations.size();i++) {
+        this->releaseBoardsRec(node->variations.at(i));
+    }
+}
+
+GameNode* Game::createInitialRoot() {
+    GameNode *root = this->arena.create();
+    Board initial(true);
+    root->setBoard(initial);
+    return root;
 }
 
 GameNode* Game::getRootNode() {
@@ -67,21 +131,42 @@ void Game::setResult(int r) {
 }
 
 void Game::setHeader(QString tag, QString value) {
+    this->rawHeaders.remove(tag);
     this->headers[tag] = value;
 }
 
+void Game::setRawHeader(const QString &tag, const QByteArray &value, bool isUtf8) {
+    this->headers.remove(tag);
+    this->rawHeaders[tag] = value;
+    this->rawHeadersUtf8 = isUtf8;
+}
+
 QString Game:: getHeader(QString tag) {
+    if(this->rawHeaders.contains(tag)) {
+        QByteArray raw = this->rawHeaders.take(tag);
+        if(this->rawHeadersUtf8) {
+            this->headers[tag] = QString::fromUtf8(raw);
+        } else {
+            this->headers[tag] = QString::fromLatin1(raw);
+        }
+    }
     return this->headers[tag];
 }
 
 QStringList Game::getTags() {
-    QStringList tags;
+    // tags of decoded and raw headers, in order
+    QMap<QString, bool> all;
     QMapIterator<QString, QString> i(this->headers);
     while (i.hasNext()) {
         i.next();
-        tags.append(i.key());
+        all.insert(i.key(), true);
+    }
+    QMapIterator<QString, QByteArray> j(this->rawHeaders);
+    while (j.hasNext()) {
+        j.next();
+        all.insert(j.key(), true);
     }
-    return tags;
+    return all.keys();
 }
 
 /*
@@ -113,26 +198,51 @@ bool Game::hasCommentSubstringBelow(QString &s, GameNode* temp, bool caseSensiti
 
 bool Game::matchesPosition(quint64 posHash) {
 
+    // position hashes are stored with each node, so
+    // that no boards need to be reconstructed here
     GameNode* temp = this->getRootNode();
-    Board *b = temp->getBoard();
-    //std::cout << *b << std::endl;
-    if(temp->getBoard()->get_pos_hash() == posHash) {
+    if(temp->getPosHash() == posHash) {
         return true;
     }
     while(temp->variations.size() > 0) {
         temp = temp->getVariation(0);
-        b = temp->getBoard();
-        //std::cout << *b << std::endl;
-        //qDebug() << "";
-        //qDebug().noquote() << b->printRaw();
-        //qDebug() << "";
-        if(temp->getBoard()->get_pos_hash() == posHash) {
+        if(temp->getPosHash() == posHash) {
             return true;
         }
     }
     return false;
 }
 
+GameNode* Game::findIllegalMove() {
+    GameNode *result = nullptr;
+    if(!this->getRootNode()->getBoard()->is_consistent()) {
+        result = this->getRootNode();
+    } else {
+        result = this->findIllegalMoveRec(this->getRootNode());
+    }
+    if(this->checkpointInterval > 0) {
+        this->releaseBoards();
+    }
+    return result;
+}
+
+GameNode* Game::findIllegalMoveRec(GameNode *node) {
+    Board *b = node->getBoard();
+    for(int i=0;i < node->variations.size();i++) {
+        GameNode *child_i = node->variations.at(i);
+        Move m = child_i->getMove();
+        // null moves are allowed anywhere in pgn
+        if(!m.is_null && !b->is_legal_move(m)) {
+            return child_i;
+        }
+        GameNode *result = this->findIllegalMoveRec(child_i);
+        if(result != nullptr) {
+            return result;
+        }
+    }
+    return nullptr;
+}
+
 bool isThreefoldRepetition() {
     //TODO
     return false;
@@ -214,20 +324,33 @@ void Game::goToRoot() {
 }
 
 void Game::resetWithNewRootBoard(chess::Board new_root_board) {
-    chess::GameNode* old_root = this->getRootNode();
-    this->delBelow(old_root);
-    chess::GameNode* new_root = new chess::GameNode();
+    this->arena.clear();
+    chess::GameNode* new_root = this->createNode();
     new_root->setBoard(new_root_board);
     this->setRoot(new_root);
     this->setCurrent(new_root);
     this->result = RES_UNDEF;
     this->clearHeaders();
     this->treeWasChanged = true;
-    delete old_root;
+}
+
+void Game::reset() {
+    // constant time, nodes are not freed one by one
+    this->arena.clear();
+    this->root = this->createInitialRoot();
+    this->current = this->root;
+    this->result = RES_UNDEF;
+    this->treeWasChanged = false;
+    this->headers.clear();
+    this->rawHeaders.clear();
+    this->rawHeadersUtf8 = true;
+    this->wasEcoClassified = false;
+    this->ecoInfo = EcoInfo();
 }
 
 void Game::clearHeaders() {
     this->headers.clear();
+    this->rawHeaders.clear();
     this->headers.insert(("Event"), "");
     this->headers.insert("Site","");
     this->headers.insert("Date","");
@@ -254,16 +377,7 @@ void Game::applyMove(Move &m) {
         }
     }
     if(!exists_child) {
-        GameNode *current = this->getCurrentNode();
-        Board *b_current = current->getBoard();
-        Board b_child = Board(*b_current);
-        b_child.apply(m);
-        GameNode *new_current = new GameNode();
-        new_current->setBoard(b_child);
-        new_current->setMove(m);
-        new_current->setParent(current);
-        current->variations.append(new_current);
-        this->current = new_current;
+        this->current = this->createChild(this->current, m);
         this->treeWasChanged = true;
     }
 }
@@ -311,17 +425,16 @@ void Game::delVariant(GameNode *node) {
     }
     if(idx != -1) {
         var_root->variations.removeAt(idx);
-        delete child;
+        this->arena.release(child);
         this->current = var_root;
     }
 }
 
 void Game::delBelow(GameNode *node) {
     for(int i=0;i<node->variations.size();i++) {
-        GameNode *child_i = node->variations.at(i);
-        node->variations.removeAt(i);
-        delete child_i;
+        this->arena.release(node->variations.at(i));
     }
+    node->variations.clear();
     this->current = node;
 }
 
@@ -345,8 +458,7 @@ void Game::removeAllVariants() {
         GameNode *main = temp->variations.at(0);
         // delete all variants
         for(int i=1;i<size;i++) {
-            GameNode *ni = temp->variations.at(i);
-            delete ni;
+            this->arena.release(temp->variations.at(i));
         }
         temp->variations.clear();
         temp->addVariation(main);
@@ -367,11 +479,12 @@ void Game::findEco() {
     }
     int maxdepth = depth;
     while(depth >= 2)  {
-        Board b_temp = temp->getBoard();
+        Board b_temp = *temp->getBoard();
         EcoInfo e_temp = ec->classify(b_temp);
         if(!e_temp.code.isEmpty()) {
             this->ecoInfo = EcoInfo(e_temp);
             this->wasEcoClassified = true;
+            this->rawHeaders.remove("ECO");
             this->headers.insert("ECO", e_temp.code);
             delete ec;
             break;
@@ -23,6 +23,7 @@
 
 #include "game_node.h"
 #include "ecocode.h"
+#include "node_arena.h"
 
 namespace chess {
 
@@ -49,6 +50,14 @@ public:
 
 
     void setHeader(QString tag, QString value);
+
+    /**
+     * @brief setRawHeader sets a header value as undecoded bytes, e.g.
+     *        straight from a pgn file. The value is decoded only once
+     *        it is requested by getHeader()
+     * @param isUtf8 whether value is UTF-8 or ISO 8859-1 encoded
+     */
+    void setRawHeader(const QString &tag, const QByteArray &value, bool isUtf8);
     QString getHeader(QString tag);
     void resetHeaders();
     QStringList getTags();
@@ -67,6 +76,52 @@ public:
      */
     GameNode* getRootNode();
 
+    /**
+     * @brief createNode creates a node that is owned by this game. All
+     *                   nodes of a game are allocated from an arena, and
+     *                   are released at once when the game is reset or
+     *                   destroyed. Never delete such a node yourself.
+     *                   The board of the returned node is undefined and
+     *                   must be set with setBoard().
+     * @return
+     */
+    GameNode* createNode();
+
+    /**
+     * @brief createChild creates a node for move m, and appends it as last
+     *                    variation of parent. The board of the new node is
+     *                    built in place from the one of parent, i.e. with
+     *                    one board copy at most. If a checkpoint interval is
+     *                    set, and parent is no checkpoint, parent's cached
+     *                    board is handed down instead, without any copy.
+     *                    m is not checked for legality.
+     * @param parent node of this game
+     * @param m the move leading from parent to the new node
+     * @return the new node
+     */
+    GameNode* createChild(GameNode *parent, const Move &m);
+
+    /**
+     * @brief setCheckpointInterval controls how many boards are kept in
+     *                              memory. With interval n > 0, only the
+     *                              root and every n-th node on each line
+     *                              keep a board, all other nodes store just
+     *                              their move, and boards are reconstructed
+     *                              on demand, cf. GameNode::getBoard().
+     *                              With 0 (the default), every node keeps
+     *                              its board. Applies to nodes added later on,
+     *                              and is kept when the game is reset.
+     * @param n the checkpoint interval
+     */
+    void setCheckpointInterval(int n);
+    int getCheckpointInterval();
+
+    /**
+     * @brief releaseBoards frees all boards that were reconstructed or
+     *                      cached, so that only the checkpoints keep one
+     */
+    void releaseBoards();
+
     /**
      * @brief getEndNode returns end of mainline
      * @return
@@ -123,8 +178,7 @@ public:
 
     /**
      * @brief setRoot sets the root node pointer to the supplied node. Really just that.
-     *                Beware of memory leaks when using this function, as nodes below
-     *                the old root might become inaccessible
+     *                The node should be created with createNode() of this game
      * @param new_root
      */
     void setRoot(GameNode *new_root);
@@ -179,14 +233,17 @@ public:
     /**
      * @brief delVariant deletes the whole variation on which the supplied node exists. I.e.
      *        moves up the tree to the root of the variation, and deletes everything below.
-     *        sets current node pointer to the root of the variation.
+     *        sets current node pointer to the root of the variation. Deleted
+     *        nodes are recycled by the game's arena, so pointers to them must not
+     *        be used anymore. Their boards are freed.
      * @param node
      */
     void delVariant(GameNode *node);
 
     /**
      * @brief delBelow delete the subtree below the supplied node. Afterwards sets current
-     *        node pointer to the supplied node.
+     *        node pointer to the supplied node. Deleted nodes are recycled like
+     *        in delVariant().
      * @param node
      */
     void delBelow(GameNode *node);
@@ -214,6 +271,14 @@ public:
      */
     void resetWithNewRootBoard(Board new_root_board);
 
+    /**
+     * @brief reset deletes the whole game tree, all headers and the result,
+     *              i.e. afterwards the game is the same as a newly
+     *              constructed one. Use this to read many games into one
+     *              Game object.
+     */
+    void reset();
+
     /**
      * @brief removeAllComments iterates through the tree, and removes every
      *                          comment from each GameNode
@@ -223,7 +288,8 @@ public:
     /**
      * @brief removeAllVariants iterates through the tree and keeps only the
      *                          mainlines (i.e. zeroth) variations if there
-     *                          are more than one child in a GameNode
+     *                          are more than one child in a GameNode. Deleted
+     *                          nodes are recycled like in delVariant()
      */
     void removeAllVariants();
 
@@ -235,6 +301,19 @@ public:
 
     bool matchesPosition(quint64 posHash);
 
+    /**
+     * @brief findIllegalMove replays the whole tree and checks that the start
+     *                        position is consistent, and that every move is
+     *                        legal. Use to validate games that were read in
+     *                        trusted mode, cf. PgnReader::setTrusted(). Does
+     *                        not change the tree, and can thus be run later,
+     *                        e.g. in a background thread that owns the game.
+     * @return the root if the start position is not consistent, otherwise the
+     *         first node (depth first) with an illegal move, or null if all
+     *         moves are legal
+     */
+    GameNode* findIllegalMove();
+
     /**
      * @brief clearHeaders deletes all headers entries.
      */
@@ -255,11 +334,19 @@ public:
 private:
 
     QMap<QString, QString> headers;
+    // header values set by setRawHeader() that are not decoded yet
+    QMap<QString, QByteArray> rawHeaders;
+    bool rawHeadersUtf8;
     bool treeWasChanged;
+    NodeArena arena;
     GameNode* root;
     GameNode* current;
     int result;
     GameNode* findNodeByIdRec(int id, GameNode* node);
+    GameNode* findIllegalMoveRec(GameNode* node);
+    GameNode* createInitialRoot();
+    int checkpointInterval;
+    void releaseBoardsRec(GameNode *node);
 
     bool hasCommentSubstringBelow(QString &s, GameNode* node, bool caseSensitive);
 
@@ -0,0 +1,461 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "game_db.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStringList>
+#include <QPair>
+#include <stdexcept>
+
+namespace chess {
+
+// "CLDB", followed by the format version. increment the
+// version whenever the layout of games or the file changes
+static const quint32 DB_MAGIC = 0x434c4442;
+static const quint32 DB_VERSION = 2;
+
+// a game starts with a flags byte. the lowest two bits are the result
+// (RES_UNDEF ... DRAW), the others mark which optional sections follow.
+// the layout of a game is:
+//   flags
+//   table tags one bit for each of TABLE_TAGS that the game has, so
+//              that tags with empty values are restored as well
+//   [fen]      size, utf8 bytes
+//   [tags]     count, then name and value (size, utf8 bytes) of each tag
+//   moves      count, then each move as 16 bit little endian code
+//   [comments] count, then node, size and utf8 bytes of each comment
+//   [nags]     count, then node, number of nags and the nags of each node
+// all counts, sizes and numbers are varints. nodes are numbered in the
+// order they are decoded, the root is node 0
+static const quint8 GAME_RESULT_MASK = 0x03;
+static const quint8 GAME_HAS_FEN = 0x04;
+static const quint8 GAME_HAS_TAGS = 0x08;
+static const quint8 GAME_HAS_COMMENTS = 0x10;
+static const quint8 GAME_HAS_NAGS = 0x20;
+
+// codes that are not moves. null moves are encoded with just
+// the null flag set, so the low bits are free for markers
+static const quint16 CODE_BEGIN_VARIATION = Move::MOVE_NULL_FLAG | 1;
+static const quint16 CODE_END_VARIATION = Move::MOVE_NULL_FLAG | 2;
+
+// the tags that are stored in the header table
+static const char* const TABLE_TAGS[] = {
+    "Event", "Site", "Date", "Round", "White", "Black", "Result", "ECO"
+};
+
+static void put_varint(QByteArray &out, quint32 v) {
+    while(v >= 0x80) {
+        out.append(char((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+static void put_bytes(QByteArray &out, const QByteArray &bytes) {
+    put_varint(out, quint32(bytes.size()));
+    out.append(bytes);
+}
+
+static void put_code(QByteArray &out, quint16 code) {
+    out.append(char(code & 0xff));
+    out.append(char(code >> 8));
+}
+
+static bool get_varint(const uchar *&p, const uchar *end, quint32 &v) {
+    v = 0;
+    for(int shift=0;shift<32 && p < end;shift+=7) {
+        uchar c = *p++;
+        v |= quint32(c & 0x7f) << shift;
+        if(!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool get_bytes(const uchar *&p, const uchar *end, QByteArray &bytes) {
+    quint32 size = 0;
+    if(!get_varint(p, end, size) || size > quint32(end - p)) {
+        return false;
+    }
+    bytes = QByteArray(reinterpret_cast<const char*>(p), int(size));
+    p += size;
+    return true;
+}
+
+// collects the codes and annotations of a game tree
+struct GameEncoder
+{
+    QByteArray codes;
+    quint32 code_count;
+    quint32 node_count;
+    QVector<QPair<quint32, QByteArray> > comments;
+    QVector<QPair<quint32, QVector<int> > > nags;
+
+    GameEncoder() : code_count(0), node_count(0) {}
+
+    void addCode(quint16 code) {
+        put_code(this->codes, code);
+        this->code_count++;
+    }
+
+    void addAnnotations(GameNode *node, quint32 index) {
+        QString comment = node->getComment();
+        if(!comment.isEmpty()) {
+            this->comments.append(qMakePair(index, comment.toUtf8()));
+        }
+        QVector<int> node_nags = node->getNags();
+        if(!node_nags.isEmpty()) {
+            this->nags.append(qMakePair(index, node_nags));
+        }
+    }
+
+    void addMove(GameNode *node) {
+        this->addCode(node->getMove().pack());
+        this->node_count++;
+        this->addAnnotations(node, this->node_count);
+    }
+
+    // the line starting after node, as in pgn: the main move
+    // first, then its alternatives, each enclosed by markers
+    void addLine(GameNode *node) {
+        while(!node->isLeaf()) {
+            QVector<GameNode*> children = node->getVariations();
+            GameNode *main = children.at(0);
+            this->addMove(main);
+            for(int i=1;i<children.size();i++) {
+                this->addCode(CODE_BEGIN_VARIATION);
+                this->addMove(children.at(i));
+                this->addLine(children.at(i));
+                this->addCode(CODE_END_VARIATION);
+            }
+            node = main;
+        }
+    }
+};
+
+GameDb::GameDb() {
+}
+
+void GameDb::append(Game &g) {
+
+    // getHeader() creates missing tags, so look them up first
+    QStringList tags = g.getTags();
+    QString values[PgnHeaderTable::COLUMN_COUNT];
+    quint8 table_tags = 0;
+    for(int i=0;i<PgnHeaderTable::COLUMN_COUNT;i++) {
+        if(tags.contains(TABLE_TAGS[i])) {
+            values[i] = g.getHeader(TABLE_TAGS[i]);
+            table_tags |= quint8(1 << i);
+        }
+    }
+    PgnHeader header;
+    header.event = values[PgnHeaderTable::EVENT];
+    header.site = values[PgnHeaderTable::SITE];
+    header.date = values[PgnHeaderTable::DATE];
+    header.round = values[PgnHeaderTable::ROUND];
+    header.white = values[PgnHeaderTable::WHITE];
+    header.black = values[PgnHeaderTable::BLACK];
+    header.result = values[PgnHeaderTable::RESULT];
+    header.eco = values[PgnHeaderTable::ECO];
+
+    quint8 flags = quint8(g.getResult()) & GAME_RESULT_MASK;
+    QByteArray sections;
+
+    GameNode *root = g.getRootNode();
+    Board *b = root->getBoard();
+    if(!b->is_initial_position()) {
+        flags |= GAME_HAS_FEN;
+        put_bytes(sections, b->fen().toUtf8());
+    }
+
+    QStringList extra_tags;
+    for(int i=0;i<tags.size();i++) {
+        bool in_table = false;
+        for(int j=0;j<PgnHeaderTable::COLUMN_COUNT && !in_table;j++) {
+            in_table = tags.at(i) == TABLE_TAGS[j];
+        }
+        if(!in_table) {
+            extra_tags.append(tags.at(i));
+        }
+    }
+    if(!extra_tags.isEmpty()) {
+        flags |= GAME_HAS_TAGS;
+        put_varint(sections, quint32(extra_tags.size()));
+        for(int i=0;i<extra_tags.size();i++) {
+            put_bytes(sections, extra_tags.at(i).toUtf8());
+            put_bytes(sections, g.getHeader(extra_tags.at(i)).toUtf8());
+        }
+    }
+
+    GameEncoder enc;
+    enc.addAnnotations(root, 0);
+    enc.addLine(root);
+    put_varint(sections, enc.code_count);
+    sections.append(enc.codes);
+
+    if(!enc.comments.isEmpty()) {
+        flags |= GAME_HAS_COMMENTS;
+        put_varint(sections, quint32(enc.comments.size()));
+        for(int i=0;i<enc.comments.size();i++) {
+            put_varint(sections, enc.comments.at(i).first);
+            put_bytes(sections, enc.comments.at(i).second);
+        }
+    }
+    if(!enc.nags.isEmpty()) {
+        flags |= GAME_HAS_NAGS;
+        put_varint(sections, quint32(enc.nags.size()));
+        for(int i=0;i<enc.nags.size();i++) {
+            const QVector<int> &node_nags = enc.nags.at(i).second;
+            put_varint(sections, enc.nags.at(i).first);
+            put_varint(sections, quint32(node_nags.size()));
+            for(int j=0;j<node_nags.size();j++) {
+                put_varint(sections, quint32(node_nags.at(j)));
+            }
+        }
+    }
+
+    qint64 offset = this->data.size();
+    this->data.append(char(flags));
+    this->data.append(char(table_tags));
+    this->data.append(sections);
+    this->offsets.append(offset);
+    this->headers.append(offset, header);
+}
+
+int GameDb::size() const {
+    return this->offsets.size();
+}
+
+bool GameDb::readGame(int idx, Game *g) const {
+
+    if(idx < 0 || idx >= this->offsets.size()) {
+        return false;
+    }
+    g->reset();
+
+    const uchar *start = reinterpret_cast<const uchar*>(this->data.constData());
+    const uchar *p = start + this->offsets.at(idx);
+    const uchar *end = start + this->data.size();
+    if(idx + 1 < this->offsets.size()) {
+        end = start + this->offsets.at(idx + 1);
+    }
+    if(end - p < 2) {
+        return false;
+    }
+    quint8 flags = *p++;
+    quint8 table_tags = *p++;
+    GameNode *root = g->getRootNode();
+
+    if(flags & GAME_HAS_FEN) {
+        QByteArray fen;
+        if(!get_bytes(p, end, fen)) {
+            return false;
+        }
+        try {
+            Board b(QString::fromUtf8(fen));
+            root->setBoard(b);
+        }
+        catch(std::invalid_argument &) {
+            return false;
+        }
+    }
+
+    // roster values are already decoded in the table
+    for(int i=0;i<PgnHeaderTable::COLUMN_COUNT;i++) {
+        if(table_tags & (1 << i)) {
+            g->setHeader(TABLE_TAGS[i], this->headers.value(idx, PgnHeaderTable::Column(i)));
+        }
+    }
+    if(flags & GAME_HAS_TAGS) {
+        quint32 count = 0;
+        if(!get_varint(p, end, count)) {
+            return false;
+        }
+        for(quint32 i=0;i<count;i++) {
+            QByteArray name, value;
+            if(!get_bytes(p, end, name) || !get_bytes(p, end, value)) {
+                return false;
+            }
+            g->setRawHeader(QString::fromUtf8(name), value, true);
+        }
+    }
+    g->setResult(flags & GAME_RESULT_MASK);
+
+    quint32 code_count = 0;
+    if(!get_varint(p, end, code_count) || code_count > quint32(end - p) / 2) {
+        return false;
+    }
+    // nodes by number, only needed to attach annotations
+    bool annotated = (flags & (GAME_HAS_COMMENTS | GAME_HAS_NAGS)) != 0;
+    QVector<GameNode*> nodes;
+    if(annotated) {
+        nodes.append(root);
+    }
+    QVector<GameNode*> stack;
+    GameNode *current = root;
+    for(quint32 i=0;i<code_count;i++) {
+        quint16 code = quint16(p[0] | (p[1] << 8));
+        p += 2;
+        if(code == CODE_BEGIN_VARIATION) {
+            // an alternative to the last move
+            if(current == root) {
+                return false;
+            }
+            stack.append(current);
+            current = current->getParent();
+        } else if(code == CODE_END_VARIATION) {
+            if(stack.isEmpty()) {
+                return false;
+            }
+            current = stack.takeLast();
+        } else {
+            Move m = Move::unpack(code);
+            if(!m.is_null) {
+                // don't let corrupt data move pieces that don't exist
+                Board *b = current->getBoard();
+                if(b->get_piece_at(m.from) == EMPTY || b->get_piece_color(m.from) != b->turn) {
+                    return false;
+                }
+            }
+            current = g->createChild(current, m);
+            if(annotated) {
+                nodes.append(current);
+            }
+        }
+    }
+    if(!stack.isEmpty()) {
+        return false;
+    }
+
+    if(flags & GAME_HAS_COMMENTS) {
+        quint32 count = 0;
+        if(!get_varint(p, end, count)) {
+            return false;
+        }
+        for(quint32 i=0;i<count;i++) {
+            quint32 node = 0;
+            QByteArray comment;
+            if(!get_varint(p, end, node) || node >= quint32(nodes.size())
+                    || !get_bytes(p, end, comment)) {
+                return false;
+            }
+            nodes.at(node)->setRawComment(comment, true);
+        }
+    }
+    if(flags & GAME_HAS_NAGS) {
+        quint32 count = 0;
+        if(!get_varint(p, end, count)) {
+            return false;
+        }
+        for(quint32 i=0;i<count;i++) {
+            quint32 node = 0;
+            quint32 nag_count = 0;
+            if(!get_varint(p, end, node) || node >= quint32(nodes.size())
+                    || !get_varint(p, end, nag_count)) {
+                return false;
+            }
+            for(quint32 j=0;j<nag_count;j++) {
+                quint32 nag = 0;
+                if(!get_varint(p, end, nag)) {
+                    return false;
+                }
+                nodes.at(node)->addNag(int(nag));
+            }
+        }
+    }
+
+    if(g->getCheckpointInterval() > 0) {
+        g->releaseBoards();
+    }
+    return true;
+}
+
+const PgnHeaderTable& GameDb::getHeaders() const {
+    return this->headers;
+}
+
+void GameDb::clear() {
+    this->offsets.clear();
+    this->headers.clear();
+    this->data.clear();
+}
+
+bool GameDb::load(const QString &filename) {
+
+    this->clear();
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if(magic != DB_MAGIC || version != DB_VERSION) {
+        return false;
+    }
+    bool ok = readVector(in, this->offsets, sizeof(qint64))
+            && this->headers.load(in, this->offsets, true);
+    if(ok) {
+        in >> this->data;
+        ok = in.status() == QDataStream::Ok;
+    }
+    // games must be in order and within the data
+    for(int i=0;i<this->offsets.size() && ok;i++) {
+        qint64 offset = this->offsets.at(i);
+        ok = offset < this->data.size() && (i == 0 || offset > this->offsets.at(i-1));
+    }
+    if(ok && !this->offsets.isEmpty()) {
+        ok = this->offsets.at(0) == 0;
+    }
+    if(!ok) {
+        this->clear();
+        return false;
+    }
+    return true;
+}
+
+bool GameDb::save(const QString &filename) const {
+
+    QSaveFile file(filename);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << DB_MAGIC << DB_VERSION;
+    out << this->offsets;
+    this->headers.save(out);
+    out << this->data;
+    if(out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+}
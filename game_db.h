@@ -0,0 +1,103 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef GAME_DB_H
+#define GAME_DB_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include "game.h"
+#include "pgn_header_table.h"
+
+namespace chess {
+
+/**
+ * @brief GameDb a compact binary container of games, as an alternative
+ *        to pgn files that need all moves to be parsed from san again
+ *        whenever they are opened.
+ *
+ *        The seven tag roster and the ECO code of all games are kept in
+ *        a header table with a pool of distinct strings, cf. PgnHeaderTable.
+ *        Moves are stored in their packed 16 bit form (cf. Move::pack()), so
+ *        reading a game just applies moves, without resolving san or
+ *        generating any moves. Variations are marked inline. Other tags, a
+ *        FEN start position, comments and NAGs are stored in optional
+ *        sections of a game, that cost nothing if a game has none.
+ *
+ *        The whole database is kept in memory. It can hold up to 2 GB
+ *        of move data.
+ */
+class GameDb
+{
+
+public:
+    GameDb();
+
+    /**
+     * @brief append encodes game g and adds it at the end
+     */
+    void append(Game &g);
+
+    /**
+     * @brief size number of games
+     */
+    int size() const;
+
+    /**
+     * @brief readGame decodes the game at index idx into g. Previous
+     *        content of g is cleared, cf. Game::reset()
+     * @return false if idx is out of range or the game data is corrupt
+     */
+    bool readGame(int idx, Game *g) const;
+
+    /**
+     * @brief getHeaders header columns of all games, e.g. to fill a game list
+     */
+    const PgnHeaderTable& getHeaders() const;
+
+    void clear();
+
+    /**
+     * @brief load reads a database file, replacing the current content
+     * @return false, if the file doesn't exist, is corrupt or
+     *         has a different format version. The database is
+     *         then empty
+     */
+    bool load(const QString &filename);
+
+    /**
+     * @brief save writes the database to a file. Writing is atomic, i.e.
+     *        an existing file is only replaced on success
+     */
+    bool save(const QString &filename) const;
+
+private:
+    // start of each game in data
+    QVector<qint64> offsets;
+    PgnHeaderTable headers;
+    QByteArray data;
+
+};
+
+}
+
+#endif // GAME_DB_H
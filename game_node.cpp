@@ -26,15 +26,65 @@
 
 namespace chess {
 
-int GameNode::id = 0;
+QAtomicInt GameNode::id(0);
+
+// ids a thread takes from the global counter at once
+static const int ID_RANGE_SIZE = 1024;
+
+// next free id of this thread, and end of its range
+static thread_local int id_next = 0;
+static thread_local int id_end = 0;
+
+int GameNode::initId() {
+    if(id_next == id_end) {
+        id_next = id.fetchAndAddRelaxed(ID_RANGE_SIZE);
+        id_end = id_next + ID_RANGE_SIZE;
+    }
+    return id_next++;
+}
 
 GameNode::GameNode() {
 
-    this->board = Board(true);
+    // the board is allocated when it is set, or reconstructed
+    this->board = nullptr;
+    this->spareBoard = nullptr;
+    this->checkpointDistance = 0;
+    this->posHash = 0;
     this->parent = nullptr;
     this->nodeId = this->initId();
     this->depthCache = 0;
     this->userWasInformedAboutResult = false;
+    this->rawCommentUtf8 = true;
+}
+
+GameNode::~GameNode() {
+    this->freeBoards();
+}
+
+void GameNode::reset() {
+    if(this->board != nullptr) {
+        if(this->spareBoard == nullptr) {
+            this->spareBoard = this->board;
+        } else {
+            delete this->board;
+        }
+        this->board = nullptr;
+    }
+    this->nodeId = this->initId();
+    this->checkpointDistance = 0;
+    this->posHash = 0;
+    this->depthCache = 0;
+    this->userWasInformedAboutResult = false;
+    this->m = Move();
+    this->nags.resize(0);
+    this->comment.clear();
+    this->rawComment.clear();
+    this->rawCommentUtf8 = true;
+    this->san_cache.clear();
+    this->arrows.resize(0);
+    this->coloredFields.resize(0);
+    this->parent = nullptr;
+    this->variations.resize(0);
 }
 
 /*
@@ -61,7 +111,7 @@ int GameNode::getDepth() {
 }
 
 QString GameNode::getSan(Move &m) {
-    return this->board.san(m);
+    return this->getBoard()->san(m);
 }
 
 QString GameNode::getSan() {
@@ -98,18 +148,97 @@ QVector<int> GameNode::getNags() {
 
 void GameNode::setComment(QString &c) {
     this->comment = c;
+    this->rawComment.clear();
+}
+
+void GameNode::setRawComment(const QByteArray &c, bool isUtf8) {
+    this->comment.clear();
+    this->rawComment = c;
+    this->rawCommentUtf8 = isUtf8;
 }
 
 QString GameNode::getComment() {
+    if(!this->rawComment.isEmpty()) {
+        if(this->rawCommentUtf8) {
+            this->comment = QString::fromUtf8(this->rawComment);
+        } else {
+            this->comment = QString::fromLatin1(this->rawComment);
+        }
+        this->rawComment.clear();
+    }
     return this->comment;
 }
 
 Board* GameNode::getBoard() {
-    return &(this->board);
+    if(this->board == nullptr) {
+        // replay the moves from the nearest node that has a board
+        QVector<GameNode*> path;
+        GameNode *temp = this;
+        while(temp != nullptr && temp->board == nullptr) {
+            path.append(temp);
+            temp = temp->parent;
+        }
+        this->board = this->allocBoard();
+        if(temp != nullptr) {
+            this->board->copy_position(*temp->board);
+        } else {
+            // a detached node without any board
+            *this->board = Board(true);
+            path.removeLast();
+        }
+        for(int i=path.size()-1;i>=0;i--) {
+            this->board->clear_history();
+            this->board->apply(path.at(i)->m);
+        }
+        this->posHash = this->board->get_pos_hash();
+    }
+    return this->board;
 }
 
 void GameNode::setBoard(Board &b) {
-    this->board = b;
+    if(this->board == nullptr) {
+        this->board = this->allocBoard();
+    }
+    *this->board = b;
+    this->posHash = b.get_pos_hash();
+}
+
+Board* GameNode::allocBoard() {
+    if(this->spareBoard != nullptr) {
+        Board *b = this->spareBoard;
+        this->spareBoard = nullptr;
+        return b;
+    }
+    return new Board(false);
+}
+
+void GameNode::freeBoards() {
+    delete this->board;
+    delete this->spareBoard;
+    this->board = nullptr;
+    this->spareBoard = nullptr;
+}
+
+bool GameNode::hasBoard() {
+    return this->board != nullptr;
+}
+
+bool GameNode::isCheckpoint() {
+    return this->checkpointDistance == 0;
+}
+
+void GameNode::releaseBoard() {
+    if(this->checkpointDistance > 0) {
+        delete this->board;
+        this->board = nullptr;
+    }
+}
+
+quint64 GameNode::getPosHash() {
+    if(this->board == nullptr && this->posHash == 0) {
+        this->getBoard();
+    }
+    return this->posHash;
 }
 
 /*
@@ -28,6 +28,7 @@
 #include "arrow.h"
 #include "colored_field.h"
 #include <QVector>
+#include <QAtomicInt>
 
 namespace chess {
 
@@ -39,13 +40,23 @@ public:
 
     GameNode();
 
+    /**
+     * @brief reset puts the node back into the state of a newly
+     *              constructed one, with a new id. The node then has no
+     *              board, i.e. getBoard() gives the initial position as long
+     *              as the node has no parent. The memory of a board is kept
+     *              for the next one though. Vectors keep their capacity as
+     *              well, so that recycled nodes don't allocate again.
+     */
+    void reset();
+
     /**
      * @brief The destructor does NOT delete child nodes. You
      *        are responsible yourself for deleting child nodes.
      *        In general, member functions from Game() to manage
      *        the tree should be used.
      */
-    //~GameNode();
+    ~GameNode();
 
 
 
@@ -57,19 +68,52 @@ public:
     int getId();
 
     /**
-     * @brief getBoard
+     * @brief getBoard returns the board of this node. If the node
+     *                 does not keep a board (cf. Game::setCheckpointInterval()),
+     *                 it is reconstructed by replaying the moves from the
+     *                 nearest ancestor that has one, and cached until
+     *                 releaseBoard() is called.
      * @return Board of current node
      */
     Board* getBoard();
 
     /**
-     * @brief setBoard deletes the old board of this node, and sets
-     *                 the supplied board as the new one. Does no
-     *                 validity checks of the board position
-     * @param b The board. Must not be null.
+     * @brief setBoard overwrites the board of this node with
+     *                 the supplied one. Does no validity checks
+     *                 of the board position
+     * @param b The board.
      */
     void setBoard(Board &b);
 
+    /**
+     * @brief hasBoard checks whether the node currently holds a board,
+     *                 either as checkpoint or as cached reconstruction
+     * @return true if getBoard() does not need to replay moves
+     */
+    bool hasBoard();
+
+    /**
+     * @brief isCheckpoint checks whether the node keeps its board
+     *                     permanently. Boards of all other nodes are
+     *                     only cached, and can be released.
+     * @return true if the board of this node is never released
+     */
+    bool isCheckpoint();
+
+    /**
+     * @brief releaseBoard frees the cached board of a node that is not
+     *                     a checkpoint. Does nothing for checkpoints.
+     */
+    void releaseBoard();
+
+    /**
+     * @brief getPosHash returns the position hash (cf. Board::get_pos_hash())
+     *                   of the board of this node. Available also if the
+     *                   board itself is not kept.
+     * @return the position hash
+     */
+    quint64 getPosHash();
+
     /**
      * @brief getSan returns san string of move that
      *               lead to this node.
@@ -120,6 +164,16 @@ public:
      */
     void setComment(QString &c);
 
+    /**
+     * @brief setRawComment sets the comment as undecoded bytes, e.g. straight
+     *        from a pgn file. The bytes are decoded only once getComment()
+     *        is called, so that comments that are never looked at cost no
+     *        conversion.
+     * @param c the comment bytes
+     * @param isUtf8 whether c is UTF-8 or ISO 8859-1 encoded
+     */
+    void setRawComment(const QByteArray &c, bool isUtf8);
+
     /**
      * @brief getComment returns the comment for this node. Empty text string
      *                   if there is no comment.
@@ -216,16 +270,32 @@ public:
 
 
 protected:
-    static int initId() { return id++; }
+    // games may be parsed concurrently. each thread takes
+    // ranges of ids from the global counter, and hands out
+    // ids of its range without synchronization
+    static int initId();
 
 private:
-    static int id;
+    Q_DISABLE_COPY(GameNode)
+
+    static QAtomicInt id;
     int nodeId;
     int depthCache;
     Move m;
-    Board board;
+    // null if the board is not kept, and not cached either
+    Board *board;
+    // memory of the board before reset(). its content is meaningless,
+    // it is only reused when the node gets a board again
+    Board *spareBoard;
+    // number of moves to the nearest ancestor that is a checkpoint,
+    // zero if this node is one
+    int checkpointDistance;
+    quint64 posHash;
     QVector<int> nags;
     QString comment;
+    // comment as set by setRawComment() that is not decoded yet
+    QByteArray rawComment;
+    bool rawCommentUtf8;
     QString san_cache;
 
     QVector<Arrow> arrows;
@@ -236,7 +306,13 @@ private:
 
     QString getSan(Move &m);
 
+    // takes the spare board, or allocates a new one. content is undefined
+    Board* allocBoard();
+    // frees the board and the spare board
+    void freeBoards();
+
     friend class Game;
+    friend class NodeArena;
 };
 
 }
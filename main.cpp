@@ -4,6 +4,8 @@
 #include <QTextCodec>
 #include "pgn_reader.h"
 #include "pgn_printer.h"
+#include "pgn_bulk_reader.h"
+#include "pgn_game_iterator.h"
 #include <iostream>
 #include <QDebug>
 #include <QTimer>
@@ -14,6 +16,13 @@ int main(int argc, char *argv[])
 
     //chess::TestCases cases;
     //cases.run_pertf();
+    //cases.run_polyglot_keys();
+    //cases.run_pgn_scanner();
+    //cases.run_pgn_bulk_reader();
+    //cases.run_moves_only();
+    //cases.run_pgn_index();
+    //cases.run_pgn_header_table();
+    //cases.run_game_db();
 
     QCoreApplication a(argc, argv);
 
@@ -22,6 +31,23 @@ int main(int argc, char *argv[])
 
 
         QString fn_in = a.arguments().at(1);
+
+        if(fn_in == "-") {
+            // read games from stdin one by one,
+            // no offsets and just one game in memory
+            QFile in;
+            if(!in.open(stdin, QIODevice::ReadOnly)) {
+                throw std::invalid_argument("unable to read from stdin");
+            }
+            chess::PgnGameIterator games(&in, true);
+            int count = 0;
+            while(games.next()) {
+                count++;
+            }
+            qDebug() << "read" << count << "games";
+            return 0;
+        }
+
         QFile file(fn_in);
 
         if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -31,33 +57,16 @@ int main(int argc, char *argv[])
         chess::PgnReader pgnReader;
         bool isUtf8 = pgnReader.isUtf8(fn_in);
         //qDebug() << "Detected Utf8: " << isUtf8;
-        QVector<qint64> offsets = pgnReader.scanPgn(fn_in, isUtf8);
-
-        //qDebug() << "scanning finished!";
-        QTextStream in(&file);
-        QTextCodec *codecUtf8 = QTextCodec::codecForName("UTF-8");
-        QTextCodec *codecLatin1 = QTextCodec::codecForName("ISO 8859-1");
-
-        if(isUtf8) {
-            in.setCodec(codecUtf8);
-        } else {
-            in.setCodec(codecLatin1);
-        }
+        QVector<qint64> offsets = pgnReader.scanPgnIndexed(fn_in, isUtf8);
 
         qDebug() << "scanning finished";
         //qDebug() << offsets.size();
 
-
-        chess::PgnPrinter pgnPrinter;
-        for(int i=0;i<offsets.size();i++) {
-            //std::cout << "READING GAME: " << i << std::endl;
-            chess::Game *g = new chess::Game();
-            pgnReader.readGame(in,offsets.at(i),g);
-            //std::cout << pgnPrinter.printGame(*g).join("\n").toStdString() << std::endl;
-            //std::cout << std::endl;
-            //g->reset();
+        // parse all games on all cores
+        chess::PgnBulkReader bulkReader;
+        bulkReader.readGames(fn_in, offsets, isUtf8, [](int, chess::Game *g, int) {
             delete g;
-        }
+        });
         qDebug() << "read succ";
     }
 
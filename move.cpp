@@ -56,18 +56,6 @@ Move::Move() {
 
 Move::Move(int from, int to, int promotion_piece) {
 
-    QChar prom_piece;
-    if(promotion_piece == KNIGHT) {
-        prom_piece = QChar('N');
-    } else if (promotion_piece == BISHOP) {
-        prom_piece = QChar('B');
-    } else if (promotion_piece == ROOK) {
-        prom_piece = QChar('R');
-    } else if (promotion_piece == QUEEN) {
-        prom_piece = QChar('Q');
-    } else {
-        prom_piece = QChar(' ');
-    }
     this->from = from;
     this->to = to;
     this->promotion_piece = promotion_piece;
@@ -24,6 +24,7 @@
 #include <QString>
 #include <tuple>
 #include <QPoint>
+#include "bitboard.h"
 
 
 namespace chess {
@@ -137,6 +138,53 @@ public:
     QPoint fromAsXY() const;
     QPoint toAsXY() const;
 
+    /**
+     * @brief pack encodes the move in 16 bits: bits 0-5 source square,
+     *             bits 6-11 target square (both 0...63, A1 = 0),
+     *             bits 12-13 promotion piece (KNIGHT ... QUEEN),
+     *             bit 14 set if the move promotes,
+     *             bit 15 set for the null move.
+     * @return packed move
+     */
+    inline quint16 pack() const {
+        if(this->is_null) {
+            return MOVE_NULL_FLAG;
+        }
+        return pack(idx_to_sq(this->from), idx_to_sq(this->to), this->promotion_piece);
+    }
+
+    /**
+     * @brief pack encodes a move given by bitboard squares (0...63). see pack()
+     * @param promotion_piece 0 or one of KNIGHT ... QUEEN
+     * @return packed move
+     */
+    static inline quint16 pack(int from_sq, int to_sq, int promotion_piece) {
+        quint16 packed = quint16(from_sq | (to_sq << 6));
+        if(promotion_piece != 0) {
+            packed |= quint16(((promotion_piece - 2) << 12) | MOVE_PROMOTION_FLAG);
+        }
+        return packed;
+    }
+
+    /**
+     * @brief unpack creates a move from its 16 bit encoding, see pack()
+     * @param packed encoded move
+     * @return the move
+     */
+    static inline Move unpack(quint16 packed) {
+        if(packed & MOVE_NULL_FLAG) {
+            return Move();
+        }
+        int promotion_piece = 0;
+        if(packed & MOVE_PROMOTION_FLAG) {
+            promotion_piece = ((packed >> 12) & 3) + 2;
+        }
+        return Move(sq_to_idx(packed & 63), sq_to_idx((packed >> 6) & 63), promotion_piece);
+    }
+
+    static const quint16 MOVE_PROMOTION_FLAG = 0x4000;
+    static const quint16 MOVE_NULL_FLAG = 0x8000;
+
 private:
 
     int alpha_to_pos(QChar alpha);
@@ -145,5 +193,74 @@ private:
 
 };
 
+/**
+ * @brief MoveList fixed capacity list of moves, stored packed (see Move::pack()).
+ *                 Lives on the stack, so move generation needs no heap
+ *                 allocation. 256 exceeds the maximum number of
+ *                 pseudo legal moves in any chess position.
+ */
+class MoveList
+{
+
+public:
+
+    static const int CAPACITY = 256;
+
+    MoveList() : n(0) {}
+
+    inline void append(const Move &m) {
+        Q_ASSERT(this->n < CAPACITY);
+        this->moves[this->n++] = m.pack();
+    }
+
+    /**
+     * @brief add appends a move given by bitboard squares (0...63)
+     */
+    inline void add(int from_sq, int to_sq, int promotion_piece = 0) {
+        Q_ASSERT(this->n < CAPACITY);
+        this->moves[this->n++] = Move::pack(from_sq, to_sq, promotion_piece);
+    }
+
+    inline Move at(int i) const {
+        Q_ASSERT(i >= 0 && i < this->n);
+        return Move::unpack(this->moves[i]);
+    }
+
+    inline quint16 packed_at(int i) const {
+        return this->moves[i];
+    }
+
+    inline int size() const {
+        return this->n;
+    }
+
+    inline int count() const {
+        return this->n;
+    }
+
+    inline bool isEmpty() const {
+        return this->n == 0;
+    }
+
+    inline void clear() {
+        this->n = 0;
+    }
+
+    bool contains(const Move &m) const {
+        quint16 packed = m.pack();
+        for(int i=0;i<this->n;i++) {
+            if(this->moves[i] == packed) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    quint16 moves[CAPACITY];
+    int n;
+
+};
+
 }
 #endif // MOVE_H
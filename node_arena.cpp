@@ -0,0 +1,74 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "node_arena.h"
+
+namespace chess {
+
+NodeArena::NodeArena() {
+    this->used = 0;
+}
+
+NodeArena::~NodeArena() {
+    for(int i=0;i<this->blocks.size();i++) {
+        NodePool::returnBlock(this->blocks.at(i));
+    }
+}
+
+GameNode* NodeArena::create() {
+    if(!this->freed.isEmpty()) {
+        GameNode *node = this->freed.takeLast();
+        node->reset();
+        return node;
+    }
+    int block = this->used / NodeBlock::SIZE;
+    if(block == this->blocks.size()) {
+        this->blocks.append(NodePool::takeBlock());
+    }
+    GameNode *node = &this->blocks.at(block)->nodes[this->used % NodeBlock::SIZE];
+    this->used++;
+    // blocks from the pool may contain nodes of earlier games
+    node->reset();
+    return node;
+}
+
+void NodeArena::release(GameNode *node) {
+    // no recursion, lines can be long
+    int first = this->freed.size();
+    this->freed.append(node);
+    for(int i=first;i<this->freed.size();i++) {
+        GameNode *temp = this->freed.at(i);
+        this->freed += temp->variations;
+        temp->variations.resize(0);
+        temp->freeBoards();
+    }
+}
+
+void NodeArena::clear() {
+    this->used = 0;
+    this->freed.resize(0);
+}
+
+int NodeArena::size() const {
+    return this->used - this->freed.size();
+}
+
+}
@@ -0,0 +1,89 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <QVector>
+#include <QtGlobal>
+#include "game_node.h"
+#include "node_pool.h"
+
+namespace chess {
+
+/**
+ * @brief NodeArena allocates the GameNodes of one game. Nodes are
+ *        handed out from blocks of the NodePool, and are never freed
+ *        one by one. Blocks go back to the pool when the arena is
+ *        destroyed.
+ *        clear() makes all nodes available again in constant time,
+ *        without running destructors. Blocks and the heap memory of
+ *        recycled nodes (nag, arrow and variation vectors) are then
+ *        reused by the next game. Subtrees that are deleted while the
+ *        game is edited are put on a free list with release(), and
+ *        their nodes are handed out again first.
+ */
+class NodeArena
+{
+
+public:
+    NodeArena();
+    ~NodeArena();
+
+    /**
+     * @brief create returns a node in the state of a newly constructed
+     *        one (with a new id), cf. GameNode::reset()
+     */
+    GameNode* create();
+
+    /**
+     * @brief release puts node and all nodes below it on the free list,
+     *        and frees their boards. The subtree must already be unlinked
+     *        from the game, and pointers to its nodes must not be used
+     *        anymore
+     */
+    void release(GameNode *node);
+
+    /**
+     * @brief clear releases all nodes at once. Pointers to
+     *        nodes of this arena must not be used afterwards
+     */
+    void clear();
+
+    /**
+     * @brief size number of nodes in use
+     */
+    int size() const;
+
+private:
+    Q_DISABLE_COPY(NodeArena)
+
+    QVector<NodeBlock*> blocks;
+    // nodes handed out since the last clear()
+    int used;
+    // released nodes, handed out again before unused ones
+    QVector<GameNode*> freed;
+
+};
+
+}
+
+#endif // NODE_ARENA_H
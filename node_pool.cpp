@@ -1,45 +1,161 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
 #include "node_pool.h"
-#include <QDebug>
+#include <QAtomicPointer>
 
 namespace chess {
 
-QVector<GameNode*> NodePool::freeList;
+// free blocks a thread keeps for itself
+static const int LOCAL_MAX_BLOCKS = 8;
+// blocks a thread takes from the global list at once
+static const int LOCAL_REFILL_BLOCKS = 4;
 
-NodePool::NodePool()
-{
+// global free list (a Treiber stack). blocks are only ever pushed
+// one chain at a time, and popped by taking the whole list with one
+// atomic exchange. no thread ever dereferences the head of a list it
+// doesn't own, so there is no ABA problem
+static QAtomicPointer<NodeBlock> global_free(nullptr);
 
+static void push_global(NodeBlock *first, NodeBlock *last) {
+    NodeBlock *head;
+    do {
+        head = global_free.loadAcquire();
+        last->next = head;
+    } while(!global_free.testAndSetOrdered(head, first));
 }
 
-void NodePool::reserve() {
+static NodeBlock* take_global() {
+    return global_free.fetchAndStoreAcquire(nullptr);
+}
 
-    for(int i=0;i<MAX_NODE_COUNT;i++) {
-        GameNode *node = new GameNode();
-        NodePool::freeList.append(node);
+// thread local cache of free blocks
+class LocalBlocks
+{
+
+public:
+    LocalBlocks() : head(nullptr), count(0) {}
+
+    ~LocalBlocks() {
+        // free the blocks of a finished thread. handing them to the
+        // global list instead would pile them up, as each bulk read
+        // runs on threads of its own
+        NodeBlock *block = this->head;
+        while(block != nullptr) {
+            NodeBlock *next = block->next;
+            delete block;
+            block = next;
+        }
     }
-}
 
-GameNode* NodePool::makeNode() {
+    NodeBlock *head;
+    int count;
 
-    //assert(NodePool::freeList.size() > 0);
-    if(NodePool::freeList.size() == 0) {
-        //qDebug() << "EMPTY STORE, increasing!";
-        GameNode *node = new GameNode();
-        NodePool::freeList.append(node);
+};
+
+static thread_local LocalBlocks local_blocks;
+
+NodeBlock* NodePool::takeBlock() {
+
+    LocalBlocks &local = local_blocks;
+    if(local.head == nullptr) {
+        // refill from the global list: keep some blocks,
+        // and give the rest back to the other threads
+        NodeBlock *all = take_global();
+        if(all == nullptr) {
+            NodeBlock *block = new NodeBlock();
+            block->next = nullptr;
+            return block;
+        }
+        NodeBlock *last = all;
+        int n = 1;
+        while(n < LOCAL_REFILL_BLOCKS && last->next != nullptr) {
+            last = last->next;
+            n++;
+        }
+        NodeBlock *rest = last->next;
+        last->next = nullptr;
+        if(rest != nullptr) {
+            NodeBlock *rest_last = rest;
+            while(rest_last->next != nullptr) {
+                rest_last = rest_last->next;
+            }
+            push_global(rest, rest_last);
+        }
+        local.head = all;
+        local.count = n;
     }
-    return NodePool::freeList.takeLast();
+    NodeBlock *block = local.head;
+    local.head = block->next;
+    local.count--;
+    block->next = nullptr;
+    return block;
 }
 
-void NodePool::deleteNode(GameNode* node) {
+void NodePool::returnBlock(NodeBlock *block) {
 
-    // recursively put back all child nodes
-    QVector<GameNode*> children = node->getVariations();
-    for(int i=0;i<children.size();i++) {
-        GameNode* child_i = children.at(i);
-        NodePool::deleteNode(child_i);
+    LocalBlocks &local = local_blocks;
+    block->next = local.head;
+    local.head = block;
+    local.count++;
+    if(local.count > LOCAL_MAX_BLOCKS) {
+        // move the older half to the global list
+        NodeBlock *last = local.head;
+        for(int i=1;i<LOCAL_MAX_BLOCKS / 2;i++) {
+            last = last->next;
+        }
+        NodeBlock *first = last->next;
+        last->next = nullptr;
+        NodeBlock *moved_last = first;
+        while(moved_last->next != nullptr) {
+            moved_last = moved_last->next;
+        }
+        push_global(first, moved_last);
+        local.count = LOCAL_MAX_BLOCKS / 2;
     }
-    NodePool::freeList.append(node);
-    node->reset();
 }
 
+void NodePool::reserve(int count) {
+    int blocks = (count + NodeBlock::SIZE - 1) / NodeBlock::SIZE;
+    if(blocks <= 0) {
+        return;
+    }
+    NodeBlock *first = new NodeBlock();
+    first->next = nullptr;
+    NodeBlock *last = first;
+    for(int i=1;i<blocks;i++) {
+        NodeBlock *block = new NodeBlock();
+        block->next = first;
+        first = block;
+    }
+    push_global(first, last);
+}
+
+void NodePool::trim() {
+    NodeBlock *block = take_global();
+    while(block != nullptr) {
+        NodeBlock *next = block->next;
+        delete block;
+        block = next;
+    }
+}
 
 }
@@ -0,0 +1,86 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include "game_node.h"
+
+namespace chess {
+
+/**
+ * @brief NodeBlock a block of game nodes, the unit in which
+ *        NodeArena gets nodes from the NodePool
+ */
+struct NodeBlock
+{
+    // boards are not part of the nodes, so blocks are small,
+    // and a typical game fits into two of them
+    static const int SIZE = 64;
+
+    GameNode nodes[SIZE];
+    // next block in a free list
+    NodeBlock *next;
+};
+
+/**
+ * @brief NodePool recycles node blocks between games, and between
+ *        threads. Each thread keeps a few free blocks in a thread local
+ *        cache, so that taking and returning blocks needs no
+ *        synchronization at all in the common case. If a cache runs
+ *        empty or grows too large, blocks are moved in batches to or
+ *        from a global lock-free free list.
+ *
+ *        All functions are thread-safe.
+ */
+class NodePool
+{
+
+public:
+
+    /**
+     * @brief takeBlock returns a free block. Nodes in the block
+     *        are either new or were used by an earlier game
+     */
+    static NodeBlock* takeBlock();
+
+    /**
+     * @brief returnBlock puts a block that is no longer used back
+     */
+    static void returnBlock(NodeBlock *block);
+
+    /**
+     * @brief reserve allocates blocks for count nodes in advance,
+     *        and puts them into the global free list
+     */
+    static void reserve(int count);
+
+    /**
+     * @brief trim frees all blocks in the global free list. Blocks
+     *        in thread local caches are freed when the thread ends
+     */
+    static void trim();
+
+};
+
+}
+
+#endif // NODE_POOL_H
@@ -0,0 +1,219 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "perft.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+
+namespace chess {
+
+PerftHash::PerftHash(int size_mb) {
+    this->entries = nullptr;
+    this->mask = 0;
+    if(size_mb <= 0) {
+        return;
+    }
+    // largest power of two number of entries that fits
+    quint64 n = 1;
+    quint64 bytes = quint64(size_mb) * 1024 * 1024;
+    while(n * 2 * sizeof(HashEntry) <= bytes) {
+        n = n * 2;
+    }
+    this->entries = new HashEntry[n]();
+    this->mask = n - 1;
+}
+
+PerftHash::~PerftHash() {
+    delete[] this->entries;
+}
+
+void PerftHash::clear() {
+    if(this->entries == nullptr) {
+        return;
+    }
+    for(quint64 i=0;i<=this->mask;i++) {
+        this->entries[i].check.store(0, std::memory_order_relaxed);
+        this->entries[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// data holds the node count in the upper 56 bits,
+// and the depth in the lowest 8 bits
+bool PerftHash::probe(quint64 key, int depth, quint64 &nodes) const {
+    if(this->entries == nullptr) {
+        return false;
+    }
+    const HashEntry &e = this->entries[key & this->mask];
+    quint64 data = e.data.load(std::memory_order_relaxed);
+    quint64 check = e.check.load(std::memory_order_relaxed);
+    if((check ^ data) == key && int(data & 0xFF) == depth) {
+        nodes = data >> 8;
+        return true;
+    }
+    return false;
+}
+
+void PerftHash::store(quint64 key, int depth, quint64 nodes) {
+    if(this->entries == nullptr) {
+        return;
+    }
+    HashEntry &e = this->entries[key & this->mask];
+    quint64 data = (nodes << 8) | quint64(depth & 0xFF);
+    e.check.store(key ^ data, std::memory_order_relaxed);
+    e.data.store(data, std::memory_order_relaxed);
+}
+
+quint64 PerftResult::nps() const {
+    if(this->msecs <= 0) {
+        return this->nodes * 1000;
+    }
+    return (this->nodes * 1000) / quint64(this->msecs);
+}
+
+// one unit of work: count the subtree
+// below a position after one or two plies
+class PerftTask : public QRunnable
+{
+
+public:
+    PerftTask(Perft *perft, const Board &board, int depth, quint64 *result)
+        : perft(perft), board(board), depth(depth), result(result) {}
+
+    void run() {
+        *this->result = this->perft->count(this->board, this->depth);
+    }
+
+private:
+    Perft *perft;
+    Board board;
+    int depth;
+    quint64 *result;
+
+};
+
+Perft::Perft(int hash_mb, int threads) : hash(hash_mb) {
+    this->use_hash = hash_mb > 0;
+    this->threads = threads;
+    if(this->threads <= 0) {
+        this->threads = QThread::idealThreadCount();
+    }
+}
+
+quint64 Perft::count(Board &board, int depth) {
+
+    if(depth <= 0) {
+        return 1;
+    }
+    quint64 key = 0;
+    quint64 nodes = 0;
+    // leaves are cheaper to count than to look up
+    if(this->use_hash && depth > 1) {
+        key = board.get_zobrist();
+        if(this->hash.probe(key, depth, nodes)) {
+            return nodes;
+        }
+    }
+    MoveList moves = board.legal_moves();
+    if(depth == 1) {
+        return quint64(moves.size());
+    }
+    for(int i=0;i<moves.size();i++) {
+        board.apply(moves.at(i));
+        nodes += this->count(board, depth - 1);
+        board.undo();
+    }
+    if(this->use_hash) {
+        this->hash.store(key, depth, nodes);
+    }
+    return nodes;
+}
+
+PerftResult Perft::run(const Board &board, int depth) {
+
+    QElapsedTimer timer;
+    timer.start();
+
+    PerftResult result;
+    result.nodes = 0;
+
+    // perft(0) is the root position itself, and there
+    // are no root moves to divide the count by
+    if(depth <= 0) {
+        result.nodes = 1;
+        result.msecs = timer.elapsed();
+        return result;
+    }
+
+    Board root(board);
+    root.clear_history();
+    MoveList root_moves = root.legal_moves();
+
+    // with few root moves per thread, also split at the
+    // second ply, so that all threads stay busy until the end
+    bool split_twice = depth >= 3 && root_moves.size() < 4 * this->threads;
+
+    // positions to search, and the root move each belongs to
+    QVector<Board> positions;
+    QVector<int> root_index;
+    for(int i=0;i<root_moves.size();i++) {
+        Board b(root);
+        b.apply(root_moves.at(i));
+        b.clear_history();
+        if(split_twice) {
+            MoveList replies = b.legal_moves();
+            for(int j=0;j<replies.size();j++) {
+                Board bj(b);
+                bj.apply(replies.at(j));
+                bj.clear_history();
+                positions.append(bj);
+                root_index.append(i);
+            }
+        } else {
+            positions.append(b);
+            root_index.append(i);
+        }
+    }
+    int remaining_depth = depth - 1;
+    if(split_twice) {
+        remaining_depth = depth - 2;
+    }
+
+    QVector<quint64> counts(positions.size(), 0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(this->threads);
+    for(int i=0;i<positions.size();i++) {
+        pool.start(new PerftTask(this, positions.at(i), remaining_depth, &counts[i]));
+    }
+    pool.waitForDone();
+
+    for(int i=0;i<root_moves.size();i++) {
+        result.divide.append(qMakePair(root_moves.at(i), quint64(0)));
+    }
+    for(int i=0;i<counts.size();i++) {
+        result.divide[root_index.at(i)].second += counts.at(i);
+        result.nodes += counts.at(i);
+    }
+    result.msecs = timer.elapsed();
+    return result;
+}
+
+}
@@ -0,0 +1,123 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <QVector>
+#include <QPair>
+#include <atomic>
+#include "board.h"
+
+namespace chess {
+
+/**
+ * @brief PerftHash transposition table for subtree node counts, shared
+ *        by all perft threads without locking. Each entry stores the
+ *        data and the key xor'ed with the data. An entry that is
+ *        half-written by another thread fails the key check on probing
+ *        and is just treated as a miss.
+ */
+class PerftHash
+{
+
+public:
+    /**
+     * @brief PerftHash
+     * @param size_mb size of the table in MB. With 0 no table is
+     *                allocated, probes always miss and stores are ignored
+     */
+    PerftHash(int size_mb);
+    ~PerftHash();
+
+    bool probe(quint64 key, int depth, quint64 &nodes) const;
+    void store(quint64 key, int depth, quint64 nodes);
+    void clear();
+
+private:
+    struct HashEntry
+    {
+        std::atomic<quint64> check;
+        std::atomic<quint64> data;
+    };
+
+    HashEntry *entries;
+    quint64 mask;
+
+    Q_DISABLE_COPY(PerftHash)
+};
+
+struct PerftResult
+{
+    quint64 nodes;
+    qint64 msecs;
+    /**
+     * @brief divide node count below each legal move of the root position
+     */
+    QVector<QPair<Move, quint64> > divide;
+
+    /**
+     * @brief nps nodes per second
+     */
+    quint64 nps() const;
+};
+
+/**
+ * @brief Perft counts leaf nodes of the legal move tree. Root moves
+ *        (and for deeper searches also their replies) are distributed
+ *        as separate tasks over a thread pool. Subtree counts are
+ *        cached in a PerftHash keyed by zobrist key and depth.
+ */
+class Perft
+{
+
+public:
+    /**
+     * @brief Perft
+     * @param hash_mb size of the shared hash table in MB, 0 disables hashing
+     * @param threads number of worker threads, 0 uses one per core
+     */
+    Perft(int hash_mb = 64, int threads = 0);
+
+    /**
+     * @brief run computes perft(depth) of the supplied position in parallel
+     * @param board root position
+     * @param depth depth in plies. perft(0) is 1, without any root moves
+     * @return total nodes, time and per root move node counts
+     */
+    PerftResult run(const Board &board, int depth);
+
+    /**
+     * @brief count single threaded perft(depth). applies and undoes
+     *              moves on board, i.e. board is unchanged afterwards.
+     *              Depths <= 0 count just the position itself
+     */
+    quint64 count(Board &board, int depth);
+
+private:
+    PerftHash hash;
+    bool use_hash;
+    int threads;
+
+};
+
+}
+
+#endif // PERFT_H
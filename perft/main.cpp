@@ -0,0 +1,242 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+// Perft suite runner. Reads an EPD file where each line is a FEN
+// followed by expected node counts, i.e.
+//   <fen> ;D1 20 ;D2 400 ;D3 8902
+// and checks every (position, depth) pair. Checks are independent
+// and are distributed over all cores. Output is line based and
+// consists of key=value pairs, so that it can be diffed or parsed
+// by scripts to track move generator throughput over time.
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <iostream>
+#include <algorithm>
+#include "bitboard.h"
+#include "board.h"
+#include "perft.h"
+
+struct PerftCheck
+{
+    int position;
+    int line;
+    QString fen;
+    int depth;
+    quint64 expected;
+    quint64 nodes;
+    qint64 msecs;
+    bool error;
+};
+
+// counts one (position, depth) pair single threaded. parallelism
+// comes from running many checks at the same time
+class PerftCheckTask : public QRunnable
+{
+
+public:
+    PerftCheckTask(chess::Perft *perft, PerftCheck *check)
+        : perft(perft), check(check) {}
+
+    void run() {
+        QElapsedTimer timer;
+        timer.start();
+        try {
+            chess::Board board(this->check->fen);
+            this->check->nodes = this->perft->count(board, this->check->depth);
+        } catch(...) {
+            this->check->error = true;
+        }
+        this->check->msecs = timer.elapsed();
+    }
+
+private:
+    chess::Perft *perft;
+    PerftCheck *check;
+
+};
+
+static bool read_suite(const QString &filename, int max_depth, QVector<PerftCheck> &checks, int &positions) {
+
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    positions = 0;
+    int line_no = 0;
+    while(!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        line_no++;
+        if(line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = line.split(';');
+        QString fen = fields.at(0).trimmed();
+        positions++;
+        for(int i=1;i<fields.size();i++) {
+            QStringList dn = fields.at(i).simplified().split(' ');
+            if(dn.size() != 2 || !dn.at(0).startsWith('D')) {
+                continue;
+            }
+            bool ok_d = false;
+            bool ok_n = false;
+            int depth = dn.at(0).mid(1).toInt(&ok_d);
+            quint64 expected = dn.at(1).toULongLong(&ok_n);
+            if(!ok_d || !ok_n || depth < 1 || (max_depth > 0 && depth > max_depth)) {
+                continue;
+            }
+            PerftCheck c;
+            c.position = positions;
+            c.line = line_no;
+            c.fen = fen;
+            c.depth = depth;
+            c.expected = expected;
+            c.nodes = 0;
+            c.msecs = 0;
+            c.error = false;
+            checks.append(c);
+        }
+    }
+    return true;
+}
+
+static void print_usage() {
+    std::cerr << "usage: perft [--threads n] [--hash mb] [--max-depth n] suite.epd" << std::endl;
+    std::cerr << "  --threads n    worker threads, default one per core" << std::endl;
+    std::cerr << "  --hash mb      shared perft hash size, default 0 (off)" << std::endl;
+    std::cerr << "  --max-depth n  skip all checks deeper than n" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int threads = QThread::idealThreadCount();
+    // no hash by default, otherwise the benchmark
+    // would mostly measure hash table lookups
+    int hash_mb = 0;
+    int max_depth = 0;
+    QString filename;
+
+    QStringList args = a.arguments();
+    for(int i=1;i<args.size();i++) {
+        const QString &arg = args.at(i);
+        if((arg == "--threads" || arg == "--hash" || arg == "--max-depth") && i + 1 < args.size()) {
+            int value = args.at(++i).toInt();
+            if(arg == "--threads") {
+                threads = qMax(value, 1);
+            } else if(arg == "--hash") {
+                hash_mb = qMax(value, 0);
+            } else {
+                max_depth = value;
+            }
+        } else if(!arg.startsWith("--") && filename.isEmpty()) {
+            filename = arg;
+        } else {
+            print_usage();
+            return 2;
+        }
+    }
+    if(filename.isEmpty()) {
+        print_usage();
+        return 2;
+    }
+
+    QVector<PerftCheck> checks;
+    int positions = 0;
+    if(!read_suite(filename, max_depth, checks, positions)) {
+        std::cerr << "unable to open " << filename.toStdString() << std::endl;
+        return 2;
+    }
+
+    // build the attack tables up front, so that
+    // they don't count against the first checks
+    chess::init_bitboards();
+    chess::Perft perft(hash_mb, threads);
+
+    // start the largest checks first, so that small
+    // ones fill the gaps at the end
+    QVector<int> order;
+    for(int i=0;i<checks.size();i++) {
+        order.append(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&checks](int x, int y) {
+        return checks.at(x).expected > checks.at(y).expected;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for(int i=0;i<order.size();i++) {
+        pool.start(new PerftCheckTask(&perft, &checks[order.at(i)]));
+    }
+    pool.waitForDone();
+    qint64 wall_msecs = timer.elapsed();
+
+    quint64 total_nodes = 0;
+    int failed = 0;
+    for(int i=0;i<checks.size();i++) {
+        const PerftCheck &c = checks.at(i);
+        bool ok = !c.error && c.nodes == c.expected;
+        std::cout << "check position=" << c.position << " line=" << c.line
+                  << " depth=" << c.depth << " expected=" << c.expected
+                  << " nodes=" << c.nodes << " ms=" << c.msecs
+                  << " status=" << (c.error ? "error" : (ok ? "ok" : "fail")) << std::endl;
+        total_nodes += c.nodes;
+        if(ok) {
+            continue;
+        }
+        failed++;
+        if(c.error) {
+            std::cout << "error position=" << c.position << " fen=\"" << c.fen.toStdString() << "\"" << std::endl;
+            continue;
+        }
+        // node count below each root move, to be compared
+        // against the divide output of a reference engine
+        std::cout << "divide position=" << c.position << " depth=" << c.depth
+                  << " fen=\"" << c.fen.toStdString() << "\"" << std::endl;
+        chess::Board board(c.fen);
+        chess::PerftResult r = perft.run(board, c.depth);
+        for(int j=0;j<r.divide.size();j++) {
+            std::cout << "divide position=" << c.position << " move=" << r.divide.at(j).first.uci().toStdString()
+                      << " nodes=" << r.divide.at(j).second << std::endl;
+        }
+    }
+
+    quint64 nps = total_nodes * 1000;
+    if(wall_msecs > 0) {
+        nps = (total_nodes * 1000) / quint64(wall_msecs);
+    }
+    std::cout << "total positions=" << positions << " checks=" << checks.size()
+              << " failed=" << failed << " nodes=" << total_nodes
+              << " ms=" << wall_msecs << " nps=" << nps
+              << " threads=" << threads << " hash_mb=" << hash_mb << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+# standalone perft benchmark, runs an EPD suite
+# against the move generator of chesslib:
+#   qmake perft.pro && make
+#   ./perft perftsuite.epd
+
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = perft
+
+# remove possible other optimization flags
+QMAKE_CXXFLAGS_RELEASE -= -O
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE -= -O2
+
+# add the desired -O3 if not present
+QMAKE_CXXFLAGS_RELEASE *= -O3
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        ../bitboard.cpp \
+        ../board.cpp \
+        ../move.cpp \
+        ../perft.cpp \
+        main.cpp
+
+HEADERS += \
+    ../bitboard.h \
+    ../board.h \
+    ../constants.h \
+    ../move.h \
+    ../perft.h
@@ -0,0 +1,275 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "pgn_bulk_reader.h"
+#include "pgn_reader.h"
+#include <QFile>
+#include <QTextStream>
+#include <QTextCodec>
+#include <QMap>
+#include <QPair>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <iostream>
+#include <stdexcept>
+
+namespace chess {
+
+// games a worker claims at once
+static const int BULK_BATCH_SIZE = 64;
+
+// state shared by all workers of one readGames() call
+struct BulkReadState
+{
+    QString filename;
+    // the memory mapped file, or null if mapping failed.
+    // then each worker reads with its own text stream
+    const char *data;
+    qint64 size;
+    const QVector<qint64> *offsets;
+    bool isUtf8;
+    GameConsumer consumer;
+    bool inOrder;
+    int checkpointInterval;
+    bool trusted;
+    bool movesOnly;
+
+    // index of the next game that is not yet claimed by a worker,
+    // starts at zero
+    QAtomicInt next_claim;
+
+    QMutex mutex;
+    QWaitCondition delivered;
+    // for in order delivery: index of the next game to pass to
+    // the consumer, and finished games that have to wait for it
+    int next_delivery;
+    QMap<int, QPair<Game*, int> > finished;
+    // workers don't start batches that are more than this many
+    // games ahead of the delivery, so that finished stays small
+    int window;
+
+    void deliver(int index, Game *game, int status) {
+        QMutexLocker lock(&this->mutex);
+        if(!this->inOrder) {
+            this->consumer(index, game, status);
+            return;
+        }
+        this->finished.insert(index, qMakePair(game, status));
+        bool any = false;
+        while(!this->finished.isEmpty() && this->finished.firstKey() == this->next_delivery) {
+            QPair<Game*, int> next = this->finished.take(this->next_delivery);
+            this->consumer(this->next_delivery, next.first, next.second);
+            this->next_delivery++;
+            any = true;
+        }
+        if(any) {
+            this->delivered.wakeAll();
+        }
+    }
+
+    // blocks until the game at index is close enough to
+    // the delivery. the worker that holds the next game
+    // to deliver never waits here
+    void waitForWindow(int index) {
+        if(!this->inOrder) {
+            return;
+        }
+        QMutexLocker lock(&this->mutex);
+        while(index >= this->next_delivery + this->window) {
+            this->delivered.wait(&this->mutex);
+        }
+    }
+};
+
+class PgnBulkTask : public QRunnable
+{
+
+public:
+    PgnBulkTask(BulkReadState *state) : state(state) {}
+
+    void run() {
+        if(this->state->data != 0) {
+            this->runMapped();
+        } else {
+            this->runStream();
+        }
+    }
+
+private:
+    BulkReadState *state;
+
+    // parses game i with f and hands it over to the consumer
+    template<typename ReadFn>
+    void readOne(int i, ReadFn f) {
+        Game *g = new Game();
+        g->setCheckpointInterval(this->state->checkpointInterval);
+        int status = -1;
+        try {
+            status = f(g);
+        } catch(std::exception &e) {
+            std::cerr << e.what() << std::endl;
+        } catch(...) {
+            std::cerr << "error reading game at offset " << this->state->offsets->at(i) << std::endl;
+        }
+        this->state->deliver(i, g, status);
+    }
+
+    // claims the next batch. returns false if all games are claimed
+    bool claim(int &first, int &last) {
+        const QVector<qint64> &offsets = *this->state->offsets;
+        first = this->state->next_claim.fetchAndAddRelaxed(BULK_BATCH_SIZE);
+        if(first >= offsets.size()) {
+            return false;
+        }
+        last = qMin(first + BULK_BATCH_SIZE, offsets.size());
+        this->state->waitForWindow(first);
+        return true;
+    }
+
+    void runMapped() {
+
+        PgnReader reader;
+        reader.setTrusted(this->state->trusted);
+        reader.setMovesOnly(this->state->movesOnly);
+        const QVector<qint64> &offsets = *this->state->offsets;
+        const char *data = this->state->data;
+        qint64 size = this->state->size;
+        int first, last;
+        while(this->claim(first, last)) {
+            for(int i=first;i<last;i++) {
+                qint64 offset = offsets.at(i);
+                if(offset < 0 || offset > size) {
+                    this->state->deliver(i, new Game(), -1);
+                    continue;
+                }
+                this->readOne(i, [&](Game *g) {
+                    return reader.readGame(data + offset, size - offset, this->state->isUtf8, g);
+                });
+            }
+        }
+    }
+
+    void runStream() {
+
+        QFile file(this->state->filename);
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            std::cerr << "unable to open pgn file" << std::endl;
+            return;
+        }
+        QTextStream in(&file);
+        if(this->state->isUtf8) {
+            in.setCodec(QTextCodec::codecForName("UTF-8"));
+        } else {
+            in.setCodec(QTextCodec::codecForName("ISO 8859-1"));
+        }
+        PgnReader reader;
+        reader.setTrusted(this->state->trusted);
+        reader.setMovesOnly(this->state->movesOnly);
+
+        const QVector<qint64> &offsets = *this->state->offsets;
+        int first, last;
+        while(this->claim(first, last)) {
+            for(int i=first;i<last;i++) {
+                // seek explicitly, readGame(in, offset, g)
+                // does not seek for offset 0
+                if(!in.seek(offsets.at(i))) {
+                    this->state->deliver(i, new Game(), -1);
+                    continue;
+                }
+                this->readOne(i, [&](Game *g) {
+                    return reader.readGame(in, g);
+                });
+            }
+        }
+    }
+
+};
+
+PgnBulkReader::PgnBulkReader(int threads, bool inOrder) {
+    this->threads = threads;
+    if(this->threads <= 0) {
+        this->threads = QThread::idealThreadCount();
+    }
+    this->inOrder = inOrder;
+    this->checkpointInterval = 0;
+    this->trusted = false;
+    this->movesOnly = false;
+}
+
+void PgnBulkReader::setCheckpointInterval(int n) {
+    this->checkpointInterval = n;
+}
+
+void PgnBulkReader::setTrusted(bool trusted) {
+    this->trusted = trusted;
+}
+
+void PgnBulkReader::setMovesOnly(bool movesOnly) {
+    this->movesOnly = movesOnly;
+}
+
+void PgnBulkReader::readGames(const QString &filename, const QVector<qint64> &offsets,
+                              bool isUtf8, GameConsumer consumer) {
+
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        throw std::invalid_argument("unable to open file w/ supplied filename");
+    }
+    // games are parsed directly from the mapped file. mapping
+    // can fail (e.g. for empty files), then fall back to streams
+    uchar *mapped = 0;
+    if(file.size() > 0) {
+        mapped = file.map(0, file.size());
+    }
+
+    BulkReadState state;
+    state.filename = filename;
+    state.data = reinterpret_cast<const char*>(mapped);
+    state.size = file.size();
+    state.offsets = &offsets;
+    state.isUtf8 = isUtf8;
+    state.consumer = consumer;
+    state.inOrder = this->inOrder;
+    state.checkpointInterval = this->checkpointInterval;
+    state.trusted = this->trusted;
+    state.movesOnly = this->movesOnly;
+    state.next_delivery = 0;
+    state.window = 4 * BULK_BATCH_SIZE * this->threads;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(this->threads);
+    for(int i=0;i<this->threads;i++) {
+        pool.start(new PgnBulkTask(&state));
+    }
+    pool.waitForDone();
+
+    if(mapped != 0) {
+        file.unmap(mapped);
+    }
+    file.close();
+}
+
+}
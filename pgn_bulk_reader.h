@@ -0,0 +1,103 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef PGN_BULK_READER_H
+#define PGN_BULK_READER_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "game.h"
+
+namespace chess {
+
+/**
+ * @brief GameConsumer receives a parsed game. index is the position
+ *        of the game's offset in the offset vector, status the return
+ *        value of PgnReader::readGame. The consumer takes ownership of
+ *        the game and must delete it.
+ */
+typedef std::function<void(int index, Game *game, int status)> GameConsumer;
+
+/**
+ * @brief PgnBulkReader parses many games of one pgn file concurrently.
+ *        Games are distributed in small batches over a pool of worker
+ *        threads. Each worker opens the file itself, and parses with
+ *        its own PgnReader.
+ *
+ *        The consumer is never called concurrently, so it does not need
+ *        any locking itself. But it blocks delivery of other games while
+ *        it runs, and should thus be fast.
+ */
+class PgnBulkReader
+{
+
+public:
+    /**
+     * @brief PgnBulkReader
+     * @param threads number of worker threads, 0 uses one per core
+     * @param inOrder if true, games are delivered in the order of the
+     *                offset vector. otherwise in the order they finish
+     */
+    PgnBulkReader(int threads = 0, bool inOrder = true);
+
+    /**
+     * @brief readGames parses the games at all supplied offsets and
+     *                  passes each to consumer. Returns once all games
+     *                  are delivered. Throws std::invalid_argument if
+     *                  the file can't be opened.
+     * @param offsets game offsets, e.g. from PgnReader::scanPgn
+     */
+    void readGames(const QString &filename, const QVector<qint64> &offsets,
+                   bool isUtf8, GameConsumer consumer);
+
+    /**
+     * @brief setCheckpointInterval sets the checkpoint interval of all
+     *                              games read from now on, cf.
+     *                              Game::setCheckpointInterval()
+     * @param n the checkpoint interval, 0 keeps the board of every node
+     */
+    void setCheckpointInterval(int n);
+
+    /**
+     * @brief setTrusted reads all games in trusted mode,
+     *                   cf. PgnReader::setTrusted()
+     */
+    void setTrusted(bool trusted);
+
+    /**
+     * @brief setMovesOnly reads just the main line of all games,
+     *                     cf. PgnReader::setMovesOnly()
+     */
+    void setMovesOnly(bool movesOnly);
+
+private:
+    int threads;
+    bool inOrder;
+    int checkpointInterval;
+    bool trusted;
+    bool movesOnly;
+
+};
+
+}
+
+#endif // PGN_BULK_READER_H
@@ -0,0 +1,148 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "pgn_game_iterator.h"
+#include <QFile>
+#include <iostream>
+#include <stdexcept>
+
+namespace chess {
+
+// bytes that are read from the device at once
+static const qint64 ITERATOR_BLOCK_SIZE = 1024 * 1024;
+
+PgnGameIterator::PgnGameIterator(QIODevice *device, bool isUtf8)
+    : scanner(isUtf8) {
+    this->device = device;
+    this->ownsDevice = false;
+    this->isUtf8 = isUtf8;
+    this->atEnd = false;
+    this->status = 0;
+    this->offset = -1;
+    this->bufferPos = 0;
+    this->pendingIdx = 0;
+}
+
+PgnGameIterator::PgnGameIterator(const QString &filename, bool isUtf8)
+    : scanner(isUtf8) {
+    QFile *file = new QFile(filename);
+    if(!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        throw std::invalid_argument("unable to open file w/ supplied filename");
+    }
+    this->device = file;
+    this->ownsDevice = true;
+    this->isUtf8 = isUtf8;
+    this->atEnd = false;
+    this->status = 0;
+    this->offset = -1;
+    this->bufferPos = 0;
+    this->pendingIdx = 0;
+}
+
+PgnGameIterator::~PgnGameIterator() {
+    if(this->ownsDevice) {
+        delete this->device;
+    }
+}
+
+Game* PgnGameIterator::getGame() {
+    return &this->game;
+}
+
+int PgnGameIterator::getStatus() {
+    return this->status;
+}
+
+qint64 PgnGameIterator::getOffset() {
+    return this->offset;
+}
+
+void PgnGameIterator::setTrusted(bool trusted) {
+    this->reader.setTrusted(trusted);
+}
+
+void PgnGameIterator::setMovesOnly(bool movesOnly, const MoveCallback &callback) {
+    this->reader.setMovesOnly(movesOnly);
+    this->reader.setMoveCallback(callback);
+}
+
+void PgnGameIterator::readBlock() {
+
+    // drop everything before the oldest game that is still needed.
+    // if no game start is pending, the next one can't start before
+    // the scanner's last line start. this keeps the buffer small
+    // also for long stretches of input without any game
+    qint64 keep = this->scanner.pendingStart();
+    if(this->pendingIdx < this->pending.size()) {
+        keep = this->pending.at(this->pendingIdx);
+    }
+    if(keep > this->bufferPos) {
+        this->buffer.remove(0, int(keep - this->bufferPos));
+        this->bufferPos = keep;
+    }
+    this->pending.remove(0, this->pendingIdx);
+    this->pendingIdx = 0;
+
+    QByteArray block = this->device->read(ITERATOR_BLOCK_SIZE);
+    // sockets and processes return nothing if no data has
+    // arrived yet. only closed devices (or files, for which
+    // waitForReadyRead() always fails) end the input
+    while(block.isEmpty() && this->device->isSequential()
+          && this->device->waitForReadyRead(-1)) {
+        block = this->device->read(ITERATOR_BLOCK_SIZE);
+    }
+    if(block.isEmpty()) {
+        this->atEnd = true;
+        this->pending += this->scanner.finish();
+    } else {
+        this->buffer.append(block);
+        this->scanner.scan(block.constData(), block.size());
+        this->pending += this->scanner.takeOffsets();
+    }
+}
+
+bool PgnGameIterator::next() {
+
+    // a game is complete once the start of the next game
+    // is found, or all input is read
+    while(this->pending.size() - this->pendingIdx < 2 && !this->atEnd) {
+        this->readBlock();
+    }
+    if(this->pendingIdx >= this->pending.size()) {
+        return false;
+    }
+    this->offset = this->pending.at(this->pendingIdx);
+    this->pendingIdx++;
+
+    this->game.reset();
+    qint64 start = this->offset - this->bufferPos;
+    try {
+        this->status = this->reader.readGame(this->buffer.constData() + start,
+                                             this->buffer.size() - start, this->isUtf8, &this->game);
+    } catch(std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        this->status = -1;
+    }
+    return true;
+}
+
+}
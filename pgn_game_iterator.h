@@ -0,0 +1,136 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef PGN_GAME_ITERATOR_H
+#define PGN_GAME_ITERATOR_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QIODevice>
+#include "game.h"
+#include "pgn_reader.h"
+#include "pgn_scanner.h"
+
+namespace chess {
+
+/**
+ * @brief PgnGameIterator reads the games of a pgn file or stream one
+ *        after another, without scanning for offsets first. Input is
+ *        read sequentially in blocks, so this also works for pipes like
+ *        stdin. All games are parsed into the same Game object, and only
+ *        the current game and the current block are kept in memory.
+ *
+ *        Sequential devices like sockets or processes may deliver input
+ *        in pieces. next() then blocks in QIODevice::waitForReadyRead()
+ *        until more data arrives, and input ends once the device is
+ *        closed.
+ *
+ *        Usage:
+ *
+ *            PgnGameIterator games(&device, true);
+ *            while(games.next()) {
+ *                Game *g = games.getGame();
+ *                ...
+ *            }
+ */
+class PgnGameIterator
+{
+
+public:
+    /**
+     * @brief PgnGameIterator iterates over the games of device. The
+     *        device must be open, and is not owned by the iterator
+     * @param isUtf8 encoding of the input, otherwise latin1
+     */
+    PgnGameIterator(QIODevice *device, bool isUtf8);
+
+    /**
+     * @brief PgnGameIterator iterates over the games of a file.
+     *        Throws std::invalid_argument if the file can't be opened
+     */
+    PgnGameIterator(const QString &filename, bool isUtf8);
+    ~PgnGameIterator();
+
+    /**
+     * @brief next parses the next game
+     * @return false if there are no more games
+     */
+    bool next();
+
+    /**
+     * @brief getGame the current game. Remains owned by the
+     *                iterator and is overwritten by next()
+     */
+    Game* getGame();
+
+    /**
+     * @brief getStatus result of parsing the current game,
+     *                  cf. PgnReader::readGame
+     */
+    int getStatus();
+
+    /**
+     * @brief getOffset offset of the current game in the input
+     */
+    qint64 getOffset();
+
+    /**
+     * @brief setTrusted reads the following games in trusted
+     *                   mode, cf. PgnReader::setTrusted()
+     */
+    void setTrusted(bool trusted);
+
+    /**
+     * @brief setMovesOnly reads just the main line of the following
+     *                     games, cf. PgnReader::setMovesOnly(). With a
+     *                     callback, cf. PgnReader::setMoveCallback(),
+     *                     games only get headers and result.
+     */
+    void setMovesOnly(bool movesOnly, const MoveCallback &callback = MoveCallback());
+
+private:
+    QIODevice *device;
+    bool ownsDevice;
+    bool isUtf8;
+    bool atEnd;
+
+    PgnScanner scanner;
+    PgnReader reader;
+    Game game;
+    int status;
+    qint64 offset;
+
+    // input from offset bufferPos on. bytes before the
+    // current game are dropped when the next block is read
+    QByteArray buffer;
+    qint64 bufferPos;
+    // game offsets found by the scanner, that are not read yet
+    QVector<qint64> pending;
+    int pendingIdx;
+
+    void readBlock();
+
+};
+
+}
+
+#endif // PGN_GAME_ITERATOR_H
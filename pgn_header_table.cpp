@@ -0,0 +1,346 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "pgn_header_table.h"
+#include "pgn_scanner.h"
+#include "pgn_tag.h"
+#include <QFile>
+#include <cstring>
+#include <stdexcept>
+
+namespace chess {
+
+PgnHeaderTable::PgnHeaderTable() {
+    this->clear();
+}
+
+void PgnHeaderTable::clear() {
+    this->offsets.clear();
+    for(int i=0;i<COLUMN_COUNT;i++) {
+        this->columns[i].clear();
+    }
+    this->strings.clear();
+    this->string_index.clear();
+    this->strings.append(QString(""));
+    this->string_index.insert(QByteArray(), 0);
+    this->utf8 = true;
+}
+
+void PgnHeaderTable::truncate(int row) {
+    if(row < this->offsets.size()) {
+        this->offsets.resize(row);
+        for(int i=0;i<COLUMN_COUNT;i++) {
+            this->columns[i].resize(row);
+        }
+    }
+}
+
+void PgnHeaderTable::save(QDataStream &out) const {
+    out << this->strings;
+    for(int i=0;i<COLUMN_COUNT;i++) {
+        out << this->columns[i];
+    }
+}
+
+bool PgnHeaderTable::load(QDataStream &in, const QVector<qint64> &offsets, bool isUtf8) {
+
+    this->clear();
+    // a string takes at least its 4 byte length
+    bool ok = readVector(in, this->strings, 4) && !this->strings.isEmpty();
+    for(int i=0;i<COLUMN_COUNT && ok;i++) {
+        ok = readVector(in, this->columns[i], sizeof(int))
+                && this->columns[i].size() == offsets.size();
+        for(int j=0;j<this->columns[i].size() && ok;j++) {
+            int index = this->columns[i].at(j);
+            ok = index >= 0 && index < this->strings.size();
+        }
+    }
+    if(!ok) {
+        this->clear();
+        return false;
+    }
+    this->offsets = offsets;
+    // strings were interned with the encoding of the file, so
+    // encoding them back gives the original bytes
+    this->utf8 = isUtf8;
+    this->string_index.clear();
+    this->string_index.insert(QByteArray(), 0);
+    for(int i=1;i<this->strings.size();i++) {
+        QByteArray key;
+        if(this->encode(this->strings.at(i), key)) {
+            this->string_index.insert(key, i);
+        }
+    }
+    return true;
+}
+
+int PgnHeaderTable::size() const {
+    return this->offsets.size();
+}
+
+qint64 PgnHeaderTable::offset(int row) const {
+    return this->offsets.at(row);
+}
+
+const QString& PgnHeaderTable::value(int row, Column column) const {
+    return this->strings.at(this->columns[column].at(row));
+}
+
+PgnHeader PgnHeaderTable::header(int row) const {
+    PgnHeader header;
+    header.event = this->value(row, EVENT);
+    header.site = this->value(row, SITE);
+    header.date = this->value(row, DATE);
+    header.round = this->value(row, ROUND);
+    header.white = this->value(row, WHITE);
+    header.black = this->value(row, BLACK);
+    header.result = this->value(row, RESULT);
+    header.eco = this->value(row, ECO);
+    return header;
+}
+
+int PgnHeaderTable::stringCount() const {
+    return this->strings.size();
+}
+
+bool PgnHeaderTable::encode(const QString &value, QByteArray &key) const {
+    if(this->utf8) {
+        key = value.toUtf8();
+        return true;
+    }
+    key = value.toLatin1();
+    return QString::fromLatin1(key) == value;
+}
+
+int PgnHeaderTable::intern(const QString &value) {
+    QByteArray key;
+    if(!this->encode(value, key)) {
+        // there are no bytes for the value in the encoding of
+        // the table, so it is stored, but never shared
+        this->strings.append(value);
+        return this->strings.size() - 1;
+    }
+    QHash<QByteArray, int>::const_iterator it = this->string_index.constFind(key);
+    if(it != this->string_index.constEnd()) {
+        return it.value();
+    }
+    int index = this->strings.size();
+    this->strings.append(value);
+    this->string_index.insert(key, index);
+    return index;
+}
+
+int PgnHeaderTable::intern(const char *data, int len, bool isUtf8) {
+    // the first value read decides the encoding of the keys
+    if(this->strings.size() == 1) {
+        this->utf8 = isUtf8;
+    }
+    if(isUtf8 != this->utf8) {
+        return this->intern(isUtf8 ? QString::fromUtf8(data, len) : QString::fromLatin1(data, len));
+    }
+    // lookup without copying the bytes
+    QByteArray key = QByteArray::fromRawData(data, len);
+    QHash<QByteArray, int>::const_iterator it = this->string_index.constFind(key);
+    if(it != this->string_index.constEnd()) {
+        return it.value();
+    }
+    int index = this->strings.size();
+    if(isUtf8) {
+        this->strings.append(QString::fromUtf8(data, len));
+    } else {
+        this->strings.append(QString::fromLatin1(data, len));
+    }
+    this->string_index.insert(QByteArray(data, len), index);
+    return index;
+}
+
+// column of the tag, or -1 if the tag is not in the table
+static int tag_column(const PgnTagPair &tag) {
+    switch(tag.nameSize) {
+    case 3:
+        if(tag.nameEquals("ECO")) {
+            return PgnHeaderTable::ECO;
+        }
+        break;
+    case 4:
+        if(tag.nameEquals("Site")) {
+            return PgnHeaderTable::SITE;
+        }
+        if(tag.nameEquals("Date")) {
+            return PgnHeaderTable::DATE;
+        }
+        break;
+    case 5:
+        if(tag.nameEquals("Event")) {
+            return PgnHeaderTable::EVENT;
+        }
+        if(tag.nameEquals("Round")) {
+            return PgnHeaderTable::ROUND;
+        }
+        if(tag.nameEquals("White")) {
+            return PgnHeaderTable::WHITE;
+        }
+        if(tag.nameEquals("Black")) {
+            return PgnHeaderTable::BLACK;
+        }
+        break;
+    case 6:
+        if(tag.nameEquals("Result")) {
+            return PgnHeaderTable::RESULT;
+        }
+        break;
+    }
+    return -1;
+}
+
+void PgnHeaderTable::append(qint64 offset, const char *data, qint64 len, bool isUtf8) {
+
+    int row[COLUMN_COUNT];
+    for(int i=0;i<COLUMN_COUNT;i++) {
+        row[i] = 0;
+    }
+
+    // skip UTF-8 byte order mark at the beginning of a file
+    if(len >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        len -= 3;
+    }
+    // same rules as for the header in PgnReader::readGame: empty
+    // lines and lines starting with '%' are skipped, and the
+    // header ends at the first line that is no tag pair
+    qint64 pos = 0;
+    while(pos < len) {
+        const char *line = data + pos;
+        const char *nl = static_cast<const char*>(std::memchr(line, '\n', size_t(len - pos)));
+        int size = nl != 0 ? int(nl - line) : int(len - pos);
+        pos += size + 1;
+        if(size > 0 && line[size-1] == '\r') {
+            size--;
+        }
+        if(size == 0 || line[0] == '%') {
+            continue;
+        }
+        if(line[0] != '[') {
+            break;
+        }
+        int idx = 0;
+        PgnTagPair tag;
+        if(!scanTagPair(line, size, idx, tag)) {
+            break;
+        }
+        do {
+            int column = tag_column(tag);
+            if(column >= 0) {
+                if(tag.escaped) {
+                    QByteArray value = tag.valueBytes();
+                    row[column] = this->intern(value.constData(), value.size(), isUtf8);
+                } else {
+                    row[column] = this->intern(tag.value, tag.valueSize, isUtf8);
+                }
+            }
+        } while(scanTagPair(line, size, idx, tag));
+    }
+
+    this->offsets.append(offset);
+    for(int i=0;i<COLUMN_COUNT;i++) {
+        this->columns[i].append(row[i]);
+    }
+}
+
+void PgnHeaderTable::append(qint64 offset, const PgnHeader &header) {
+
+    this->offsets.append(offset);
+    this->columns[EVENT].append(this->intern(header.event));
+    this->columns[SITE].append(this->intern(header.site));
+    this->columns[DATE].append(this->intern(header.date));
+    this->columns[ROUND].append(this->intern(header.round));
+    this->columns[WHITE].append(this->intern(header.white));
+    this->columns[BLACK].append(this->intern(header.black));
+    this->columns[RESULT].append(this->intern(header.result));
+    this->columns[ECO].append(this->intern(header.eco));
+}
+
+// reads the header lines of the game at offset, if
+// the file cannot be memory mapped
+static QByteArray read_header_lines(QFile &file, qint64 offset) {
+    QByteArray lines;
+    if(!file.seek(offset)) {
+        return lines;
+    }
+    while(!file.atEnd()) {
+        QByteArray line = file.readLine();
+        lines.append(line);
+        int first = 0;
+        if(offset == 0 && lines.size() == line.size() && line.startsWith("\xEF\xBB\xBF")) {
+            first = 3;
+        }
+        char c = line.size() > first ? line.at(first) : '\n';
+        if(c != '[' && c != '%' && c != '\n' && c != '\r') {
+            break;
+        }
+    }
+    return lines;
+}
+
+void PgnHeaderTable::read(const QString &filename, const QVector<qint64> &offsets, bool isUtf8) {
+
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        throw std::invalid_argument("unable to open file w/ supplied filename");
+    }
+    qint64 size = file.size();
+    uchar *mapped = 0;
+    if(size > 0) {
+        mapped = file.map(0, size);
+    }
+
+    this->offsets.reserve(this->offsets.size() + offsets.size());
+    for(int i=0;i<COLUMN_COUNT;i++) {
+        this->columns[i].reserve(this->columns[i].size() + offsets.size());
+    }
+
+    for(int i=0;i<offsets.size();i++) {
+        qint64 offset = offsets.at(i);
+        if(mapped != 0) {
+            const char *data = reinterpret_cast<const char*>(mapped);
+            if(offset < 0 || offset > size) {
+                this->append(offset, data, 0, isUtf8);
+            } else {
+                this->append(offset, data + offset, size - offset, isUtf8);
+            }
+        } else {
+            QByteArray lines = read_header_lines(file, offset);
+            this->append(offset, lines.constData(), lines.size(), isUtf8);
+        }
+    }
+
+    if(mapped != 0) {
+        file.unmap(mapped);
+    }
+    file.close();
+}
+
+void PgnHeaderTable::read(const QString &filename, bool isUtf8) {
+    QVector<qint64> offsets = scanPgnFile(filename, isUtf8);
+    this->read(filename, offsets, isUtf8);
+}
+
+}
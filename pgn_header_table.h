@@ -0,0 +1,197 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef PGN_HEADER_TABLE_H
+#define PGN_HEADER_TABLE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QHash>
+#include <QDataStream>
+#include <QIODevice>
+#include <climits>
+#include "pgn_reader.h"
+
+namespace chess {
+
+/**
+ * @brief readVector reads a vector written with operator<<(), like
+ *        operator>>(). But the element count taken from the stream
+ *        is checked against the data that is left on the device before
+ *        any memory is reserved. A corrupt or truncated file then just
+ *        fails to load, instead of causing a huge allocation.
+ * @param min_size number of bytes at least written per element
+ * @return false if the count can't be right, or reading fails
+ */
+template<typename T>
+bool readVector(QDataStream &in, QVector<T> &v, qint64 min_size) {
+    v.clear();
+    quint32 count = 0;
+    in >> count;
+    if(in.status() != QDataStream::Ok) {
+        return false;
+    }
+    QIODevice *device = in.device();
+    if(count > quint32(INT_MAX) || (device != nullptr && !device->isSequential()
+                                    && qint64(count) * min_size > device->bytesAvailable())) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+    v.reserve(int(count));
+    for(quint32 i=0;i<count && in.status() == QDataStream::Ok;i++) {
+        T value;
+        in >> value;
+        v.append(value);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief PgnHeaderTable the seven tag roster and the ECO code of
+ *        all games of a pgn file, e.g. to fill a game list.
+ *
+ *        Values are stored column wise as indices into a pool of
+ *        strings. Each distinct value (player names, events, dates...)
+ *        is stored and decoded only once, no matter how many games
+ *        share it.
+ *
+ *        Headers are read from the memory mapped file in one pass,
+ *        without decoding lines or parsing any moves.
+ */
+class PgnHeaderTable
+{
+
+public:
+    enum Column {
+        EVENT = 0,
+        SITE,
+        DATE,
+        ROUND,
+        WHITE,
+        BLACK,
+        RESULT,
+        ECO,
+        COLUMN_COUNT
+    };
+
+    PgnHeaderTable();
+
+    /**
+     * @brief read scans the file for games, and appends a row for each game
+     * @param filename pgn file
+     * @param isUtf8 encoding of the file, otherwise latin1
+     */
+    void read(const QString &filename, bool isUtf8);
+
+    /**
+     * @brief read appends a row for each game in offsets
+     * @param filename pgn file
+     * @param offsets game offsets, e.g. from PgnReader::scanPgn
+     * @param isUtf8 encoding of the file, otherwise latin1
+     */
+    void read(const QString &filename, const QVector<qint64> &offsets, bool isUtf8);
+
+    /**
+     * @brief append parses the header of the game at the start of data
+     *        and appends it as a new row
+     * @param offset file offset of the game, stored with the row
+     * @param data start of the game
+     * @param len number of bytes available after data
+     * @param isUtf8 encoding of data, otherwise latin1
+     */
+    void append(qint64 offset, const char *data, qint64 len, bool isUtf8);
+
+    /**
+     * @brief append appends a row with the values of header, e.g.
+     *        of a game that is not read from a pgn file
+     * @param offset offset of the game, stored with the row
+     */
+    void append(qint64 offset, const PgnHeader &header);
+
+    /**
+     * @brief size number of rows, i.e. games
+     */
+    int size() const;
+
+    /**
+     * @brief offset file offset of the game in row
+     */
+    qint64 offset(int row) const;
+
+    /**
+     * @brief value value of column in row, or an empty string
+     *        if the game has no such tag
+     */
+    const QString& value(int row, Column column) const;
+
+    /**
+     * @brief header all values of row
+     */
+    PgnHeader header(int row) const;
+
+    /**
+     * @brief stringCount number of distinct values in the table
+     */
+    int stringCount() const;
+
+    void clear();
+
+    /**
+     * @brief truncate removes all rows from row on
+     */
+    void truncate(int row);
+
+    /**
+     * @brief save writes values and the string pool to out.
+     *        Offsets are not written, cf. load()
+     */
+    void save(QDataStream &out) const;
+
+    /**
+     * @brief load reads a table written by save()
+     * @param offsets game offsets of the rows
+     * @param isUtf8 encoding of the file, otherwise latin1
+     * @return false if the data is inconsistent. The table
+     *         is then empty
+     */
+    bool load(QDataStream &in, const QVector<qint64> &offsets, bool isUtf8);
+
+private:
+    QVector<qint64> offsets;
+    QVector<int> columns[COLUMN_COUNT];
+
+    // interned values. index 0 is the empty string. keys are
+    // the values encoded as utf8 or latin1, like the first file
+    // read into the table
+    QVector<QString> strings;
+    QHash<QByteArray, int> string_index;
+    bool utf8;
+
+    int intern(const char *data, int len, bool isUtf8);
+    int intern(const QString &value);
+    bool encode(const QString &value, QByteArray &key) const;
+
+};
+
+}
+
+#endif // PGN_HEADER_TABLE_H
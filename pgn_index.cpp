@@ -0,0 +1,203 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "pgn_index.h"
+#include "pgn_scanner.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QDataStream>
+
+namespace chess {
+
+// "CLIX", followed by the format version. increment the
+// version whenever the layout of the sidecar changes
+static const quint32 INDEX_MAGIC = 0x434c4958;
+static const quint32 INDEX_VERSION = 1;
+
+// bytes at the beginning and at the end of the indexed
+// part of the file that are covered by the checksum
+static const qint64 CHECKSUM_RANGE = 64 * 1024;
+
+static void fnv1a(quint64 &h, const QByteArray &bytes) {
+    const char *data = bytes.constData();
+    for(int i=0;i<bytes.size();i++) {
+        h ^= quint8(data[i]);
+        h *= Q_UINT64_C(0x100000001b3);
+    }
+}
+
+// checksum of the first and last bytes of the first size bytes of
+// the file. reading the whole file would defeat the purpose of the
+// index. for append detection, the checksum covers the end of what
+// was indexed, so that any rewrite of the file is very likely noticed
+static quint64 sample_checksum(const QString &filename, qint64 size) {
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    quint64 h = Q_UINT64_C(0xcbf29ce484222325);
+    fnv1a(h, file.read(qMin(size, CHECKSUM_RANGE)));
+    qint64 tail = qMax(CHECKSUM_RANGE, size - CHECKSUM_RANGE);
+    if(tail < size && file.seek(tail)) {
+        fnv1a(h, file.read(size - tail));
+    }
+    file.close();
+    return h;
+}
+
+PgnIndex::PgnIndex() {
+    this->has_headers = false;
+    this->is_utf8 = true;
+    this->file_size = -1;
+    this->modified = -1;
+    this->checksum = 0;
+}
+
+QString PgnIndex::indexFilename(const QString &filename) {
+    return filename + QString(".idx");
+}
+
+const QVector<qint64>& PgnIndex::getOffsets() const {
+    return this->offsets;
+}
+
+bool PgnIndex::hasHeaders() const {
+    return this->has_headers;
+}
+
+const PgnHeaderTable& PgnIndex::getHeaders() const {
+    return this->headers;
+}
+
+int PgnIndex::open(const QString &filename, bool isUtf8, bool withHeaders) {
+
+    QFileInfo info(filename);
+    qint64 size = info.size();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    QString idx_filename = PgnIndex::indexFilename(filename);
+    PgnIndex old;
+    int result = PGN_INDEX_REBUILT;
+    if(old.load(idx_filename) && old.is_utf8 == isUtf8 && (old.has_headers || !withHeaders)
+            && old.file_size <= size && sample_checksum(filename, old.file_size) == old.checksum) {
+        if(old.file_size == size && old.modified == modified) {
+            result = PGN_INDEX_CURRENT;
+        } else if(old.file_size < size) {
+            result = PGN_INDEX_APPENDED;
+        }
+    }
+
+    if(result == PGN_INDEX_CURRENT) {
+        *this = old;
+        return result;
+    }
+
+    if(result == PGN_INDEX_APPENDED) {
+        // the last game may continue in the appended data,
+        // so scanning resumes at its start
+        this->offsets = old.offsets;
+        qint64 from = 0;
+        if(!this->offsets.isEmpty()) {
+            from = this->offsets.last();
+            this->offsets.removeLast();
+        }
+        QVector<qint64> tail = scanPgnFile(filename, isUtf8, from);
+        this->offsets += tail;
+        this->has_headers = old.has_headers;
+        if(this->has_headers) {
+            this->headers = old.headers;
+            this->headers.truncate(this->offsets.size() - tail.size());
+            this->headers.read(filename, tail, isUtf8);
+        }
+    } else {
+        this->offsets = scanPgnFile(filename, isUtf8);
+        this->has_headers = withHeaders;
+        this->headers.clear();
+        if(this->has_headers) {
+            this->headers.read(filename, this->offsets, isUtf8);
+        }
+    }
+    this->is_utf8 = isUtf8;
+    this->file_size = size;
+    this->modified = modified;
+    this->checksum = sample_checksum(filename, size);
+
+    // the index is still usable if the sidecar can't be
+    // written, e.g. for files in read only directories
+    this->save(idx_filename);
+    return result;
+}
+
+bool PgnIndex::load(const QString &indexFilename) {
+
+    QFile file(indexFilename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if(magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        return false;
+    }
+    in >> this->is_utf8 >> this->file_size >> this->modified >> this->checksum;
+    bool ok = readVector(in, this->offsets, sizeof(qint64));
+    in >> this->has_headers;
+    if(!ok || in.status() != QDataStream::Ok) {
+        *this = PgnIndex();
+        return false;
+    }
+    if(this->has_headers && !this->headers.load(in, this->offsets, this->is_utf8)) {
+        *this = PgnIndex();
+        return false;
+    }
+    return true;
+}
+
+bool PgnIndex::save(const QString &indexFilename) const {
+
+    QSaveFile file(indexFilename);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << INDEX_MAGIC << INDEX_VERSION;
+    out << this->is_utf8 << this->file_size << this->modified << this->checksum;
+    out << this->offsets;
+    out << this->has_headers;
+    if(this->has_headers) {
+        this->headers.save(out);
+    }
+    if(out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+}
@@ -0,0 +1,101 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef PGN_INDEX_H
+#define PGN_INDEX_H
+
+#include <QString>
+#include <QVector>
+#include "pgn_header_table.h"
+
+namespace chess {
+
+// result of PgnIndex::open()
+const int PGN_INDEX_CURRENT = 0;
+const int PGN_INDEX_APPENDED = 1;
+const int PGN_INDEX_REBUILT = 2;
+
+/**
+ * @brief PgnIndex game offsets of a pgn file (and optionally the
+ *        header columns of all games), kept in a binary sidecar
+ *        file next to the pgn file, e.g. games.pgn.idx
+ *
+ *        The sidecar stores size, modification time and a checksum of
+ *        the indexed file. If the file is unchanged, the index is loaded
+ *        without scanning. If data was only appended to the file, just
+ *        the new tail is scanned. Otherwise the whole file is scanned
+ *        again. The sidecar is updated in the latter two cases.
+ */
+class PgnIndex
+{
+
+public:
+    PgnIndex();
+
+    /**
+     * @brief open loads the index of the pgn file, and brings
+     *        the index and its sidecar file up to date
+     * @param filename pgn file
+     * @param isUtf8 encoding of the file, otherwise latin1
+     * @param withHeaders if true, header columns are read and stored as well
+     * @return one of PGN_INDEX_CURRENT, PGN_INDEX_APPENDED or PGN_INDEX_REBUILT
+     */
+    int open(const QString &filename, bool isUtf8, bool withHeaders = false);
+
+    const QVector<qint64>& getOffsets() const;
+
+    bool hasHeaders() const;
+    const PgnHeaderTable& getHeaders() const;
+
+    /**
+     * @brief load reads a sidecar file
+     * @return false, if the file doesn't exist, is corrupt or
+     *         has a different format version
+     */
+    bool load(const QString &indexFilename);
+
+    /**
+     * @brief save writes the sidecar file. Writing is atomic, i.e.
+     *        an existing sidecar is only replaced on success
+     */
+    bool save(const QString &indexFilename) const;
+
+    /**
+     * @brief indexFilename name of the sidecar file of a pgn file
+     */
+    static QString indexFilename(const QString &filename);
+
+private:
+    QVector<qint64> offsets;
+    PgnHeaderTable headers;
+    bool has_headers;
+
+    // the indexed file
+    bool is_utf8;
+    qint64 file_size;
+    qint64 modified;
+    quint64 checksum;
+
+};
+
+}
+
+#endif // PGN_INDEX_H
@@ -26,6 +26,7 @@
 #include <QDebug>
 #include "game.h"
 #include "pgn_printer.h"
+#include "pgn_tag.h"
 
 namespace chess {
 
@@ -84,19 +85,19 @@ void PgnPrinter::writeGame(Game &g, const QString &filename) {
 }
 
 void PgnPrinter::printHeaders(QStringList &pgn, Game &g) {
-    QString tag = "[Event \"" + g.getHeader("Event") + "\"]";
+    QString tag = "[Event \"" + escapeTagValue(g.getHeader("Event")) + "\"]";
     pgn.append(tag);
-    tag = "[Site \"" + g.getHeader("Site") + "\"]";
+    tag = "[Site \"" + escapeTagValue(g.getHeader("Site")) + "\"]";
     pgn.append(tag);
-    tag = "[Date \"" + g.getHeader("Date") + "\"]";
+    tag = "[Date \"" + escapeTagValue(g.getHeader("Date")) + "\"]";
     pgn.append(tag);
-    tag = "[Round \"" + g.getHeader("Round") + "\"]";
+    tag = "[Round \"" + escapeTagValue(g.getHeader("Round")) + "\"]";
     pgn.append(tag);
-    tag = "[White \"" + g.getHeader("White") + "\"]";
+    tag = "[White \"" + escapeTagValue(g.getHeader("White")) + "\"]";
     pgn.append(tag);
-    tag = "[Black \"" + g.getHeader("Black") + "\"]";
+    tag = "[Black \"" + escapeTagValue(g.getHeader("Black")) + "\"]";
     pgn.append(tag);
-    tag = "[Result \"" + g.getHeader("Result") + "\"]";
+    tag = "[Result \"" + escapeTagValue(g.getHeader("Result")) + "\"]";
     pgn.append(tag);
     QStringList all_tags = g.getTags();
     for(int i=0;i<all_tags.count();i++) {
@@ -105,7 +106,7 @@ void PgnPrinter::printHeaders(QStringList &pgn, Game &g) {
                 && tag_i != "White" && tag_i != "Black" && tag_i != "Result" )
         {
             QString value_i = g.getHeader(tag_i);
-            QString tag_val = "[" + tag_i + " \"" + value_i + "\"]";
+            QString tag_val = "[" + tag_i + " \"" + escapeTagValue(value_i) + "\"]";
             pgn.append(tag_val);
         }
     }
@@ -142,6 +143,11 @@ QStringList PgnPrinter::printGame(Game &g) {
     this->printResult(g.getResult());
     this->pgn.append(this->currentLine);
 
+    // printing reconstructs the boards of all nodes
+    if(g.getCheckpointInterval() > 0) {
+        g.releaseBoards();
+    }
+
     return this->pgn;
 
 }
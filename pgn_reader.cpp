@@ -21,6 +21,10 @@
 #include "pgn_reader.h"
 #include "game.h"
 #include "game_node.h"
+#include "pgn_scanner.h"
+#include "pgn_tag.h"
+#include "pgn_header_table.h"
+#include "pgn_index.h"
 #include <QFile>
 #include <QTextStream>
 #include <iostream>
@@ -29,10 +33,38 @@
 #include <QTextCodec>
 #include <QDataStream>
 #include "assert.h"
+#include <cstring>
+#include <climits>
 
 namespace chess {
 
 
+PgnReader::PgnReader() {
+    this->m_game = nullptr;
+    this->m_trusted = false;
+    this->m_movesOnly = false;
+}
+
+void PgnReader::setTrusted(bool trusted) {
+    this->m_trusted = trusted;
+}
+
+bool PgnReader::isTrusted() {
+    return this->m_trusted;
+}
+
+void PgnReader::setMovesOnly(bool movesOnly) {
+    this->m_movesOnly = movesOnly;
+}
+
+bool PgnReader::isMovesOnly() {
+    return this->m_movesOnly;
+}
+
+void PgnReader::setMoveCallback(const MoveCallback &callback) {
+    this->m_moveCallback = callback;
+}
+
 bool PgnReader::isUtf8(const QString &filename) {
     // very simple way to detecting majority of encodings:
     // first try ISO 8859-1
@@ -86,6 +118,22 @@ int PgnReader::readGameFromString(QString &pgn_string, quint64 offset, chess::Ga
 }
 
 QVector<qint64> PgnReader::scanPgn(QString &filename, bool is_utf8) {
+    // byte level scan over the memory mapped file. finds the
+    // same offsets as reading and decoding the file line by line
+    return scanPgnFile(filename, is_utf8);
+}
+
+
+QVector<qint64> PgnReader::scanPgnIndexed(QString &filename, bool isUtf8) {
+
+    PgnIndex index;
+    index.open(filename, isUtf8);
+    return index.getOffsets();
+}
+
+// the line based scanner that PgnScanner replaced. slow, but
+// simple enough to be obviously right, so it serves as reference
+QVector<qint64> PgnReader::scanPgn1(QString &filename, bool is_utf8) {
 
     QVector<qint64> offsets;
     QFile file(filename);
@@ -146,204 +194,154 @@ QVector<qint64> PgnReader::scanPgn(QString &filename, bool is_utf8) {
 }
 
 
-QVector<qint64> PgnReader::scanPgn1(QString &filename, bool is_utf8) {
+PgnHeader PgnReader::readSingleHeaderFromPgnAt(QString &filename, qint64 offset, bool isUtf8) {
 
+    // for many games, better use a PgnHeaderTable directly
+    PgnHeaderTable table;
     QVector<qint64> offsets;
-    QFile file(filename);
-
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return offsets;
+    offsets.append(offset);
+    table.read(filename, offsets, isUtf8);
+    return table.header(0);
+}
 
-    bool inComment = false;
+// source of lines for the parser. lines are returned without
+// the terminating "\n" (or "\r\n"), exactly like QTextStream::readLine()
+class PgnLineSource
+{
 
-    qint64 game_pos = -1;
+public:
+    virtual ~PgnLineSource() {}
 
-    QTextStream in(&file);
-    QTextCodec *codec;
-    if(is_utf8) {
-        codec = QTextCodec::codecForName("UTF-8");
-    } else {
-        codec = QTextCodec::codecForName("ISO 8859-1");
-    }
-    in.setCodec(codec);
+    // sets line and size to the next line. if there is no more
+    // data, sets an empty line and returns false
+    virtual bool readLine(const char *&line, int &size) = 0;
 
-    //QByteArray byteLine;
-    QString line("");
-    qint64 last_pos = file.pos();
+    virtual bool atEnd() const = 0;
 
-    int i= 0;
-    while(!in.atEnd()) {
-        i++;
-        //byteLine = file.readLine();
-        //if(!is_utf8) {
-        //    line = QString::fromLatin1(byteLine);
-        //} else {
-        //    line = QString::fromUtf8(byteLine);
-        //}
-        in.readLineInto(&line);
+};
 
-        // skip comments
-        if(line.startsWith("%")) {
-            continue;
-        }
+// lines of a byte buffer, e.g. a memory mapped file
+class PgnBufferSource : public PgnLineSource
+{
 
-        if(!inComment && line.startsWith(QString::fromLatin1("["))) { // from Latin1
+public:
+    PgnBufferSource(const char *data, qint64 len) : data(data), len(len), pos(0) {}
 
-            if(game_pos == -1) {
-                game_pos = last_pos;
-            }
-            //last_pos = file.pos();
-            continue;
-        }
-        if((!inComment && line.contains("{"))
-                || (inComment && line.contains(QString::fromLatin1("}")))) {
-            inComment = line.lastIndexOf(QString::fromLatin1("{")) > line.lastIndexOf(QString::fromLatin1("}"));
+    bool readLine(const char *&line, int &size) {
+        if(this->pos >= this->len) {
+            line = this->data + this->len;
+            size = 0;
+            return false;
         }
-
-        if(game_pos != -1) {
-            offsets.append(game_pos);
-            game_pos = -1;
+        const char *begin = this->data + this->pos;
+        const char *nl = static_cast<const char*>(std::memchr(begin, '\n', size_t(this->len - this->pos)));
+        const char *end = this->data + this->len;
+        if(nl != 0) {
+            end = nl;
+            this->pos = qint64(nl - this->data) + 1;
+            if(end > begin && *(end - 1) == '\r') {
+                end--;
+            }
+        } else {
+            this->pos = this->len;
         }
-
-        //last_pos = file.pos();
+        line = begin;
+        size = int(end - begin);
+        return true;
     }
-    // for the last game
-    if(game_pos != -1) {
-        offsets.append(game_pos);
-        game_pos = -1;
+
+    bool atEnd() const {
+        return this->pos >= this->len;
     }
 
-    return offsets;
-}
+private:
+    const char *data;
+    qint64 len;
+    qint64 pos;
 
+};
 
-PgnHeader PgnReader::readSingleHeaderFromPgnAt(QString &filename, qint64 offset, bool isUtf8) {
+// lines of a text stream. these are already decoded
+// by the stream, and are encoded back as UTF-8
+class PgnStreamSource : public PgnLineSource
+{
 
-    QFile file(filename);
+public:
+    PgnStreamSource(QTextStream &in) : in(in) {}
 
-    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        throw std::invalid_argument("unable to open file w/ supplied filename");
-    }
-    QTextStream in(&file);
-    QTextCodec *codec;
-    if(isUtf8) {
-        codec = QTextCodec::codecForName("UTF-8");
-    } else {
-        codec = QTextCodec::codecForName("ISO 8859-1");
+    bool readLine(const char *&line, int &size) {
+        bool ok = this->in.readLineInto(&this->decoded);
+        this->bytes = this->decoded.toUtf8();
+        line = this->bytes.constData();
+        size = this->bytes.size();
+        return ok;
     }
-    in.setCodec(codec);
-    if(offset != 0 && offset > 0) {
-        in.seek(offset);
-    }
-
-    PgnHeader header;
-    bool foundHeader = false;
-    bool continueSearch = true;
 
-    QString line = in.readLine();
-    while(!in.atEnd() && continueSearch) {
-        line = in.readLine();
-        if(line.startsWith("%") || line.isEmpty()) {
-            line = in.readLine();
-            continue;
-        }
-
-        QRegularExpressionMatch match_t = TAG_REGEX.match(line);
-
-        if(match_t.hasMatch()) {
+    bool atEnd() const {
+        return this->in.atEnd();
+    }
 
-            foundHeader = true;
+private:
+    QTextStream &in;
+    QString decoded;
+    QByteArray bytes;
 
-            QString tag = match_t.captured(1);
-            QString value = match_t.captured(2);
+};
 
-            if(tag == "Event") {
-                header.event = value;
-            }
-            if(tag == "Site") {
-                header.site = value;
-            }
-            if(tag == "Date") {
-                header.date = value;
-            }
-            if(tag == "Round") {
-                header.round = value;
-            }
-            if(tag == "White") {
-                header.white = value;
-            }
-            if(tag == "Black") {
-                header.black = value;
-            }
-            if(tag == "Result") {
-                header.result = value;
-            }
-            if(tag == "ECO") {
-                header.eco = value;
-            }
-        } else {
-            if(foundHeader) {
-                continueSearch = false;
-                break;
-            }
+static inline bool is_blank(const char *line, int size) {
+    for(int i=0;i<size;i++) {
+        char c = line[i];
+        if(c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '\v' && c != '\f') {
+            return false;
         }
     }
-
-    file.close();
-    return header;
+    return true;
 }
 
-
-bool PgnReader::isCol(const QChar &c) {
-    if(c >= QChar::fromLatin1('a') && c <= QChar::fromLatin1('h')) {
-        return true;
+static inline QString decode(const char *data, int size, bool isUtf8) {
+    if(isUtf8) {
+        return QString::fromUtf8(data, size);
     } else {
-        return false;
+        return QString::fromLatin1(data, size);
     }
 }
 
-bool PgnReader::isRow(const QChar &c) {
-    int row = c.digitValue() - 1;
-    if(row >= 0 && row <= 7) {
-        return true;
-    } else {
-        return false;
-    }
+bool PgnReader::isCol(char c) {
+    return c >= 'a' && c <= 'h';
 }
 
-void PgnReader::addMove(GameNode *&node, Move &m) {
+bool PgnReader::isRow(char c) {
+    return c >= '1' && c <= '8';
+}
 
-    GameNode *next = new GameNode(); //NodePool::makeNode();
-    Board* board = node->getBoard();
+void PgnReader::addMove(GameNode *&node, Move &m) {
 
-    Board b_next = Board(*board);
-    b_next.apply(m);
-    next->setMove(m);
-    next->setBoard(b_next);
-    next->setParent(node);
-    node->addVariation(next);
-    node = next;
+    // the child's board is built in place
+    node = m_game->createChild(node, m);
 }
 
+// TKN_PAWN_MOVE ... TKN_KING_MOVE, cf. parseMove()
+static inline bool is_move_token(int tkn) {
+    return tkn >= TKN_PAWN_MOVE && tkn <= TKN_KING_MOVE;
+}
 
+static inline bool is_promotion_piece(char c) {
+    return c == 'R' || c == 'B' || c == 'N' || c == 'Q';
+}
 
-bool PgnReader::parsePawnMove(QString &line, int &idx, GameNode *&node) {
+bool PgnReader::parsePawnMove(const char *line, int lineSize, int &idx, Board *board, Move &move) {
 
-    //if(idx +4 < line.size()) {
-    //    std::cout << "PARSING PAWN: " << line.mid(idx,5).toStdString() << std::endl;
-    //}
-    int col = Board::alpha_to_pos(line.at(idx));
-    Board* board = node->getBoard();
-    if(idx+1 < line.size()) {
-        if(line.at(idx+1) == QChar::fromLatin1('x')) {
+    int col = line[idx] - 'a';
+    if(idx+1 < lineSize) {
+        if(line[idx+1] == 'x') {
             // after x, next one must be letter denoting column
             // and then digit representing row, like exd4 (white)
             // then parse d, 4, and check wether there is a pawn
             // on e(4-1) = e3
-            if(idx+3 < line.size()) {
-                if(this->isCol(line.at(idx+2)) && this->isRow(line.at(idx+3))) {
-                    int col_to = Board::alpha_to_pos(line.at(idx+2));
-                    int row_to = line.at(idx+3).digitValue() - 1;
+            if(idx+3 < lineSize) {
+                if(this->isCol(line[idx+2]) && this->isRow(line[idx+3])) {
+                    int col_to = line[idx+2] - 'a';
+                    int row_to = line[idx+3] - '1';
                     int row_from = -1;
 
                     if(board->turn == WHITE && row_to - 1 >= 0 &&
@@ -355,19 +353,12 @@ bool PgnReader::parsePawnMove(QString &line, int &idx, GameNode *&node) {
                     }
                     if(row_from >= 0 && row_from <= 7) {
                         // check wether this is a promotion, i.e. exd8=Q
-                        if(idx+5 < line.size() && line.at(idx+4) == QChar::fromLatin1('=') &&
-                                (line.at(idx+5) == QChar::fromLatin1('R') ||
-                                 line.at(idx+5) == QChar::fromLatin1('B') ||
-                                 line.at(idx+5) == QChar::fromLatin1('N') ||
-                                 line.at(idx+5) == QChar::fromLatin1('Q'))) {
-                            Move m = Move(col, row_from, col_to, row_to, line.at(idx+5));
-                            this->addMove(node, m);
+                        if(idx+5 < lineSize && line[idx+4] == '=' && is_promotion_piece(line[idx+5])) {
+                            move = Move(col, row_from, col_to, row_to, QChar::fromLatin1(line[idx+5]));
                             idx += 6;
                             return true;
                         } else { // just a normal move, like exd4
-                            Move m = Move(col, row_from, col_to, row_to);
-                            //std::cout << "GOT PAWN MOVE: " << m.uci().toStdString() << std::endl;
-                            this->addMove(node, m);
+                            move = Move(col, row_from, col_to, row_to);
                             idx += 4;
                             return true;
                         }
@@ -384,8 +375,8 @@ bool PgnReader::parsePawnMove(QString &line, int &idx, GameNode *&node) {
                 return false;
             }
         } else { // only other case: must be a number
-            if(this->isRow(line.at(idx+1))) {
-                int row = line.at(idx+1).digitValue() - 1;
+            if(this->isRow(line[idx+1])) {
+                int row = line[idx+1] - '1';
                 int from_row = -1;
                 if(board->turn == WHITE) {
                     for(int row_i = row - 1;row_i>= 1;row_i--) {
@@ -404,18 +395,12 @@ bool PgnReader::parsePawnMove(QString &line, int &idx, GameNode *&node) {
                 }
                 if(from_row >= 0) { // means we found a from square
                     // check wether this is a promotion
-                    if(idx+3 < line.size() && line.at(idx+2) == QChar::fromLatin1('=') &&
-                            (line.at(idx+3) == QChar::fromLatin1('R') ||
-                             line.at(idx+3) == QChar::fromLatin1('B') ||
-                             line.at(idx+3) == QChar::fromLatin1('N') ||
-                             line.at(idx+3) == QChar::fromLatin1('Q'))) {
-                        Move m = Move(col, from_row, col, row, line.at(idx+3));
-                        this->addMove(node, m);
+                    if(idx+3 < lineSize && line[idx+2] == '=' && is_promotion_piece(line[idx+3])) {
+                        move = Move(col, from_row, col, row, QChar::fromLatin1(line[idx+3]));
                         idx += 4;
                         return true;
                     } else { // not a promotion, just a standard pawn move
-                        Move m = Move(col, from_row, col, row);
-                        this->addMove(node, m);
+                        move = Move(col, from_row, col, row);
                         idx += 2;
                         return true;
                     }
@@ -430,140 +415,52 @@ bool PgnReader::parsePawnMove(QString &line, int &idx, GameNode *&node) {
         }
     }
     idx += 2;
-    return true;
-}
-
-
-bool PgnReader::createPieceMove(uint8_t piece_type, int to_col, int to_row, GameNode *&node) {
-
-    Board *board = node->getBoard();
-    int to_internal = Board::xy_to_internal(to_col, to_row);
-    //QVector<Move> pseudos = board->pseudo_legal_moves_to(to_internal, piece_type, false, board->turn);
-    QVector<Move> pseudos = board->pseudo_legal_moves(chess::ANY_SQUARE, to_internal, piece_type, false, board->turn);
-    if(pseudos.size() == 1) {
-        Move m = pseudos.at(0);
-        this->addMove(node,m);
-        return true;
-    } else {
-        QVector<Move> legals = board->legals_from_pseudos(pseudos);
-        if(legals.size() == 1) {
-            Move m = legals.at(0);
-            this->addMove(node,m);
-            return true;
-        } else {
-            return false;
-        }
-    }
-
+    return false;
 }
 
-bool PgnReader::createPieceMove(uint8_t piece_type, int to_col, int to_row, GameNode *&node, QChar qc_from_col) {
-
-    Board *board = node->getBoard();
-    int from_col = Board::alpha_to_pos(qc_from_col);
-    int to_internal = Board::xy_to_internal(to_col, to_row);
-    //QVector<Move> pseudos = board->pseudo_legal_moves_to(to_internal, piece_type, false, board->turn);
-    QVector<Move> pseudos = board->pseudo_legal_moves(chess::ANY_SQUARE, to_internal, piece_type, false, board->turn);
-    QVector<Move> filter;
-    for(int i=0;i<pseudos.size();i++) {
-        Move m = pseudos.at(i);
-        if((m.from % 10) - 1 == from_col) {
-            filter.append(m);
-        }
-    }
-    if(filter.size() == 1) {
-        Move m = filter.at(0);
-        this->addMove(node,m);
-        return true;
-    } else {
-        QVector<Move> legals = board->legals_from_pseudos(pseudos);
-        if(legals.size() == 1) {
-            Move m = legals.at(0);
-            this->addMove(node,m);
-            return true;
-        } else {
-            return false;
-        }
-    }
-}
 
-bool PgnReader::createPieceMove(uint8_t piece_type, int to_col, int to_row, GameNode *&node, int from_row) {
+bool PgnReader::createPieceMove(uint8_t piece_type, int from_col, int from_row,
+                                int to_col, int to_row, Board *board, Move &move) {
 
-    Board *board = node->getBoard();
     int to_internal = Board::xy_to_internal(to_col, to_row);
-    //QVector<Move> pseudos = board->pseudo_legal_moves_to(to_internal, piece_type, false, board->turn);
-    QVector<Move> pseudos = board->pseudo_legal_moves(chess::ANY_SQUARE, to_internal, piece_type, false, board->turn);
-    QVector<Move> filter;    
-    for(int i=0;i<pseudos.size();i++) {
-        Move m = pseudos.at(i);
-        if((m.from / 10) - 2 == from_row) {
-            filter.append(m);
-                    //qDebug() << m.uci();
-        }
-    }
-    if(filter.size() == 1) {
-        Move m = filter.at(0);
-        this->addMove(node,m);
-        return true;
-    } else {
-        QVector<Move> legals = board->legals_from_pseudos(pseudos);
-        if(legals.size() == 1) {
-            Move m = legals.at(0);
-            this->addMove(node,m);
-            return true;
-        } else {
-            return false;
-        }
-    }
+    return board->resolve_piece_move(piece_type, to_internal, from_col, from_row, move, this->m_trusted);
 }
 
-
-bool PgnReader::parsePieceMove(uint8_t piece_type, const QString &line, int &idx, GameNode *&node) {
-
-    //qDebug() << "piece move creation 0";
-    if(idx + 4 < line.size()) {
-        //qDebug() << "parsepiece" << line.mid(idx,5);
-    }
+bool PgnReader::parsePieceMove(uint8_t piece_type, const char *line, int lineSize, int &idx, Board *board, Move &move) {
 
     // we have a piece move like "Qxe4" where index points to Q
     // First move idx after piece symbol, i.e. to ">x<e4"
     idx+=1;
-    if(idx < line.size() && line.at(idx) == QChar::fromLatin1('x')) {
+    if(idx < lineSize && line[idx] == 'x') {
         idx+=1;
     }
-    if(idx < line.size()) {
-        if(this->isCol(line.at(idx))) {
+    if(idx < lineSize) {
+        if(this->isCol(line[idx])) {
             //Qe? or Qxe?, now either digit must follow (Qe4 / Qxe4)
             //or we have a disambiguition (Qee5)
-            //qDebug() << "1111111111";
-            if(idx+1 < line.size()) {
-                if(this->isRow(line.at(idx+1))) {
-                    int to_col = Board::alpha_to_pos(line.at(idx));
-                    int to_row = line.at(idx+1).digitValue() - 1;
+            if(idx+1 < lineSize) {
+                if(this->isRow(line[idx+1])) {
+                    int to_col = line[idx] - 'a';
+                    int to_row = line[idx+1] - '1';
                     idx+=2;
                     // standard move, i.e. Qe4
-                    //qDebug() << "piece move creation 1";
-                    return createPieceMove(piece_type, to_col, to_row, node);
+                    return createPieceMove(piece_type, -1, -1, to_col, to_row, board, move);
                 } else {
                     int skip_for_take = 0;
-                    if(line.at(idx+1) == 'x' && idx + 2 < line.length()) {
-                        //System.out.println("fix");
+                    if(line[idx+1] == 'x' && idx + 2 < lineSize) {
                         skip_for_take = 1;
                         idx+=1;
                     }
-                    //qDebug() << "22222222";
-                    if(this->isCol(line.at(idx+1))) {
-                        //qDebug() << "22222222aaaaaa";
+                    if(idx+1 < lineSize && this->isCol(line[idx+1])) {
                         // we have a disambiguition, that should resolved by
                         // the column denoted in the san, here in @line[idx]
-                        int to_col = Board::alpha_to_pos(line.at(idx+1));
-                        if(idx+2 < line.size() && this->isRow(line.at(idx+2))) {
-                            int to_row = line.at(idx+2).digitValue() - 1;
+                        int to_col = line[idx+1] - 'a';
+                        if(idx+2 < lineSize && this->isRow(line[idx+2])) {
+                            int to_row = line[idx+2] - '1';
                             // move w/ disambig on col, i.e. Qee4
                             // provide line[idx] to cratePieceMove to resolve disamb.
                             idx+=3;
-                            //qDebug() << "piece move creation 2";
-                            return createPieceMove(piece_type, to_col, to_row, node, line.at(idx-(3+skip_for_take)));
+                            return createPieceMove(piece_type, line[idx-(3+skip_for_take)] - 'a', -1, to_col, to_row, board, move);
                         } else {
                             idx+=4;
                             return false;
@@ -578,23 +475,18 @@ bool PgnReader::parsePieceMove(uint8_t piece_type, const QString &line, int &idx
                return false;
            }
        } else {
-            //qDebug() << "33333333";
-            if(idx+1 < line.size() && this->isRow(line.at(idx))) {
+            if(idx+1 < lineSize && this->isRow(line[idx])) {
                 // we have a move with disamb, e.g. Q4xe5 or Q4e5
-                int from_row = line.at(idx).digitValue() - 1;
-                if(line.at(idx+1) == QChar::fromLatin1('x')) {
+                int from_row = line[idx] - '1';
+                if(line[idx+1] == 'x') {
                     idx+=1;
                 }
-                if(idx+2 < line.size() && this->isCol(line.at(idx+1)) && this->isRow(line.at(idx+2))) {
-                    int to_col = Board::alpha_to_pos(line.at(idx+1));
-                    int to_row = line.at(idx+2).digitValue() - 1;
+                if(idx+2 < lineSize && this->isCol(line[idx+1]) && this->isRow(line[idx+2])) {
+                    int to_col = line[idx+1] - 'a';
+                    int to_row = line[idx+2] - '1';
                     // parse the ambig move
                     idx+=3;
-                    //qDebug() << "creating MOVE";
-                    bool ok = createPieceMove(piece_type, to_col, to_row, node, from_row);
-                    //std::cout << *node->getBoard() << std::endl;;
-                    //qDebug() << "success: " << ok;
-                    return ok;
+                    return createPieceMove(piece_type, -1, from_row, to_col, to_row, board, move);
                 } else {
                     idx+=3;
                     return false;
@@ -608,35 +500,49 @@ bool PgnReader::parsePieceMove(uint8_t piece_type, const QString &line, int &idx
         idx+=2;
         return false;
     }
-    idx += 2;
+}
+
+bool PgnReader::parseMove(int tkn, const char *line, int lineSize, int &idx, Board *board, Move &move) {
+
+    switch(tkn) {
+    case TKN_PAWN_MOVE:
+        return parsePawnMove(line, lineSize, idx, board, move);
+    case TKN_CASTLE:
+        return parseCastleMove(line, lineSize, idx, board, move);
+    case TKN_ROOK_MOVE:
+        return parsePieceMove(ROOK, line, lineSize, idx, board, move);
+    case TKN_KNIGHT_MOVE:
+        return parsePieceMove(KNIGHT, line, lineSize, idx, board, move);
+    case TKN_BISHOP_MOVE:
+        return parsePieceMove(BISHOP, line, lineSize, idx, board, move);
+    case TKN_QUEEN_MOVE:
+        return parsePieceMove(QUEEN, line, lineSize, idx, board, move);
+    case TKN_KING_MOVE:
+        return parsePieceMove(KING, line, lineSize, idx, board, move);
+    }
     return false;
 }
 
-bool PgnReader::parseCastleMove(QString &line, int &idx, GameNode *&node) {
+bool PgnReader::parseCastleMove(const char *line, int lineSize, int &idx, Board *board, Move &move) {
 
-    int lineSize = line.size();
-    if(idx+4 < lineSize && ( line.mid(idx,5) == QString::fromLatin1("O-O-O") || line.mid(idx,5) == QString::fromLatin1("0-0-0")) ) {
-        if(node->getBoard()->turn == WHITE) {
-            Move m = Move(E1,C1);
-            this->addMove(node,m);
+    if(idx+4 < lineSize && (std::memcmp(line + idx, "O-O-O", 5) == 0 || std::memcmp(line + idx, "0-0-0", 5) == 0)) {
+        if(board->turn == WHITE) {
+            move = Move(E1,C1);
             idx += 5;
             return true;
         } else {
-            Move m = Move(E8,C8);
-            this->addMove(node,m);
+            move = Move(E8,C8);
             idx += 5;
             return true;
         }
     }
-    if(idx+2 < lineSize && ( line.mid(idx,3) == QString::fromLatin1("O-O"))) {  // || line.mid(idx,3) == QString::fromLatin1("0-0"))) {
-        if(node->getBoard()->turn == WHITE) {
-            Move m = Move(E1,G1);
-            this->addMove(node,m);
+    if(idx+2 < lineSize && std::memcmp(line + idx, "O-O", 3) == 0) {
+        if(board->turn == WHITE) {
+            move = Move(E1,G1);
             idx += 3;
             return true;
         } else {
-            Move m = Move(E8,G8);
-            this->addMove(node,m);
+            move = Move(E8,G8);
             idx += 3;
             return true;
         }
@@ -645,60 +551,59 @@ bool PgnReader::parseCastleMove(QString &line, int &idx, GameNode *&node) {
     return false;
 }
 
-void PgnReader::parseNAG(QString &line, int &idx, GameNode *node) {
-
-    int lineSize = line.size();
+void PgnReader::parseNAG(const char *line, int lineSize, int &idx, GameNode *node) {
 
-    if(line[idx] == QChar::fromLatin1('$')) {
+    if(line[idx] == '$') {
         int idx_end = idx;
-        while(idx_end < lineSize && (line.at(idx_end) == QChar::fromLatin1('$')
-                                     || (line.at(idx_end) >= QChar::fromLatin1('0')
-                                         && line.at(idx_end) <= QChar::fromLatin1('9'))))
-        {
+        while(idx_end < lineSize && (line[idx_end] == '$' || (line[idx_end] >= '0' && line[idx_end] <= '9'))) {
             idx_end++;
         }
-        if(idx_end+1 > idx) {
-            bool ok;
-            //qDebug() << line.mid(idx+1, idx_end - (idx+1));
-            int nr = line.mid(idx+1, idx_end - (idx+1)).toInt(&ok, 10);
-            if(ok) {
-                node->addNag(nr);
-                idx = idx_end;
-                //qDebug() << "after NAG: " << line.mid(idx, 5);
+        // digits after the $ sign. anything else
+        // (like another $) is not a valid number
+        bool ok = idx_end > idx + 1;
+        qint64 nr = 0;
+        for(int i=idx+1;i<idx_end && ok;i++) {
+            if(line[i] < '0' || line[i] > '9') {
+                ok = false;
             } else {
-                idx += 1;
+                nr = nr * 10 + (line[i] - '0');
+                ok = nr <= INT_MAX;
             }
+        }
+        if(ok) {
+            node->addNag(int(nr));
+            idx = idx_end;
         } else {
             idx += 1;
         }
         return;
     }
-    if(line[idx+1] < lineSize && line.midRef(idx,2) == QString::fromLatin1("??")) {
+    if(idx+1 < lineSize && line[idx] == '?' && line[idx+1] == '?') {
         node->addNag(NAG_BLUNDER);
         idx += 3;
         return;
     }
-    if(line[idx+1] < lineSize && line.midRef(idx,2) == QString::fromLatin1("!!")) {
+    if(idx+1 < lineSize && line[idx] == '!' && line[idx+1] == '!') {
         node->addNag(NAG_BRILLIANT_MOVE);
         idx += 3;
         return;
     }
-    if(line[idx+1] < lineSize && line.midRef(idx,2) == QString::fromLatin1("!?")) {
+    if(idx+1 < lineSize && line[idx] == '!' && line[idx+1] == '?') {
         node->addNag(NAG_SPECULATIVE_MOVE);
         idx += 3;
         return;
     }
-    if(line[idx+1] < lineSize && line.midRef(idx,2) == QString::fromLatin1("?!")) {
+    if(idx+1 < lineSize && line[idx] == '?' && line[idx+1] == '!') {
         node->addNag(NAG_DUBIOUS_MOVE);
         idx += 3;
         return;
     }
-    if(line[idx] == QChar::fromLatin1('?')) {
+    if(line[idx] == '?') {
         node->addNag(NAG_MISTAKE);
         idx += 2;
         return;
     }
-    if(line[idx] == QChar::fromLatin1('!')) {
+    if(line[idx] == '!') {
         node->addNag(NAG_GOOD_MOVE);
         idx += 2;
         return;
@@ -707,37 +612,36 @@ void PgnReader::parseNAG(QString &line, int &idx, GameNode *node) {
 
 
 
-int PgnReader::getNetxtToken(QString &line, int &idx) {
+int PgnReader::getNetxtToken(const char *line, int lineSize, int &idx) {
 
-    int lineSize = line.size();
     while(idx < lineSize) {
-        QChar ci = line.at(idx);
-        if(ci == QChar::fromLatin1(' ') || ci == QChar::fromLatin1('.')) {
+        char ci = line[idx];
+        if(ci == ' ' || ci == '.') {
             idx += 1;
             continue;
         }
-        if(ci >= QChar::fromLatin1('0') && ci <= QChar::fromLatin1('9')) {
-            if(ci == QChar::fromLatin1('1')) {
+        if(ci >= '0' && ci <= '9') {
+            if(ci == '1') {
                 if(idx+1 < lineSize) {
-                    if(line.at(idx+1) == QChar::fromLatin1('-')) {
-                        if(idx+2 < lineSize && line.at(idx+2) == QChar::fromLatin1('0')) {
+                    if(line[idx+1] == '-') {
+                        if(idx+2 < lineSize && line[idx+2] == '0') {
                             return TKN_RES_WHITE_WIN;
                         }
                     }
-                    if(idx+2 < lineSize && line.at(idx+1) == QChar::fromLatin1(('/'))) {
-                        if(idx+6 < lineSize && line.mid(idx,7) == QString::fromLatin1("1/2-1/2")) {
+                    if(idx+2 < lineSize && line[idx+1] == '/') {
+                        if(idx+6 < lineSize && std::memcmp(line + idx, "1/2-1/2", 7) == 0) {
                             return TKN_RES_DRAW;
                         }
                     }
                 }
             }
             // irregular castling like 0-0 or 0-0-0
-            if(ci == QChar::fromLatin1('0')) {
-                if(idx+1 < lineSize && line.at(idx+1) == QChar::fromLatin1('-')) {
-                    if(idx+2 < lineSize && line.at(idx+2) == QChar::fromLatin1('1')) {
+            if(ci == '0') {
+                if(idx+1 < lineSize && line[idx+1] == '-') {
+                    if(idx+2 < lineSize && line[idx+2] == '1') {
                         return TKN_RES_BLACK_WIN;
                     } else {
-                        if(idx+2 < lineSize && line.at(idx+2) == QChar::fromLatin1('0')) {
+                        if(idx+2 < lineSize && line[idx+2] == '0') {
                             return TKN_CASTLE;
                         }
                     }
@@ -747,49 +651,41 @@ int PgnReader::getNetxtToken(QString &line, int &idx) {
             idx += 1;
             continue;
         }
-        if(ci >= QChar::fromLatin1('a') && ci <= QChar::fromLatin1('h')) {
+        if(ci >= 'a' && ci <= 'h') {
             return TKN_PAWN_MOVE;
         }
-        if(ci == QChar::fromLatin1('O')) {
+        switch(ci) {
+        case 'O':
             return TKN_CASTLE;
-        }
-        if(ci == QChar::fromLatin1('R')) {
+        case 'R':
             return TKN_ROOK_MOVE;
-        }
-        if(ci == QChar::fromLatin1('N')) {
+        case 'N':
             return TKN_KNIGHT_MOVE;
-        }
-        if(ci == QChar::fromLatin1('B')) {
+        case 'B':
             return TKN_BISHOP_MOVE;
-        }
-        if(ci == QChar::fromLatin1('Q')) {
+        case 'Q':
             return TKN_QUEEN_MOVE;
-        }
-        if(ci == QChar::fromLatin1('K')) {
+        case 'K':
             return TKN_KING_MOVE;
-        }
-        if(ci == QChar::fromLatin1('+')) {
+        case '+':
             return TKN_CHECK;
-        }
-        if(ci == QChar::fromLatin1('(')) {
+        case '(':
             return TKN_OPEN_VARIATION;
-        }
-        if(ci == QChar::fromLatin1(')')) {
+        case ')':
             return TKN_CLOSE_VARIATION;
-        }
-        if(ci == QChar::fromLatin1('$') || ci == QChar::fromLatin1('!') || ci == QChar::fromLatin1('?')) {
+        case '$':
+        case '!':
+        case '?':
             return TKN_NAG;
-        }
-        if(ci == QChar::fromLatin1('{')) {
+        case '{':
             return TKN_OPEN_COMMENT;
-        }
-        if(ci == QChar::fromLatin1('*')) {
+        case '*':
             return TKN_RES_UNDEFINED;
-        }
-        if(ci == QChar::fromLatin1('-')) {
-            if(idx + 1 < lineSize && line.at(idx+1) == QChar::fromLatin1('-')) {
+        case '-':
+            if(idx + 1 < lineSize && line[idx+1] == '-') {
                 return TKN_NULL_MOVE;
             }
+            break;
         }
         // if none of the above match, try to continue until we
         // find another usable token
@@ -799,20 +695,45 @@ int PgnReader::getNetxtToken(QString &line, int &idx) {
 }
 
 int PgnReader::readGame(QTextStream& in, chess::Game* g) {
+    PgnStreamSource source(in);
+    return this->readGame(source, true, g);
+}
+
+int PgnReader::readGame(QTextStream &in, qint64 offset, chess::Game *g) {
 
+    if(offset != 0 && offset > 0) {
+        in.seek(offset);
+    }
+    return this->readGame(in, g);
+}
 
+int PgnReader::readGame(const char *data, qint64 len, bool isUtf8, chess::Game *g) {
+    // skip UTF-8 byte order mark at the beginning of a file,
+    // like QTextStream does
+    if(len >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        len -= 3;
+    }
+    PgnBufferSource source(data, len);
+    return this->readGame(source, isUtf8, g);
+}
+
+int PgnReader::readGame(PgnLineSource &in, bool isUtf8, chess::Game* g) {
 
     QString starting_fen = QString("");
 
+    m_game = g;
     m_game_stack.clear();
     m_game_stack.push(g->getRootNode());
     GameNode* current = g->getRootNode();
 
-    QString line = in.readLine();
+    const char *line = 0;
+    int lineSize = 0;
+    in.readLine(line, lineSize);
 
     while (!in.atEnd()) {
-        if(line.startsWith(QChar::fromLatin1('%')) || line.isEmpty()) {
-            if(in.readLineInto(&line)) {;
+        if(lineSize == 0 || line[0] == '%') {
+            if(in.readLine(line, lineSize)) {
                 continue;
             } else {
                 std::cerr << "error reading pgn file";
@@ -820,28 +741,30 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
             }
         }
 
-        if(line.startsWith(QChar::fromLatin1('['))) {
-            QRegularExpressionMatch match_t = TAG_REGEX.match(line);
-
-            if(match_t.hasMatch()) {
-                QString tag = match_t.captured(1);
-                QString value = match_t.captured(2);
+        if(line[0] == '[') {
+            int idx = 0;
+            PgnTagPair tag;
+            if(!scanTagPair(line, lineSize, idx, tag)) {
+                break;
+            }
+            // usually there is one tag pair per line, but
+            // the pgn standard also allows several
+            do {
                 // don't add FEN tag explicitly,
                 // will be always automatically generated and added
                 // when printing a game later...
-                if(tag == QString::fromLatin1("FEN")) {
-                    starting_fen = value;
+                if(tag.nameEquals("FEN")) {
+                    starting_fen = tag.valueString(isUtf8);
                 } else {
-                    g->setHeader(tag, value);
+                    // values are only decoded if someone asks for them
+                    g->setRawHeader(tag.nameString(), tag.valueBytes(), isUtf8);
                 }
-            } else {
-               break;
-            }
+            } while(scanTagPair(line, lineSize, idx, tag));
         } else {
             break;
         }
 
-        if(in.readLineInto(&line)) {;
+        if(in.readLine(line, lineSize)) {
             continue;
         } else {
             std::cerr << "error reading pgn file";
@@ -852,7 +775,7 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
     if(!starting_fen.isEmpty()) {
         try {
             chess::Board b_fen(starting_fen);
-            if(!b_fen.is_consistent()) {
+            if(!this->m_trusted && !b_fen.is_consistent()) {
                 std::cerr << "starting fen position is not consistent" << std::endl;
                 m_game_stack.clear();
                 return -1;
@@ -867,8 +790,8 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
         }
     }
     // we should now have a header, seek first non-empty line
-    while(line.trimmed() == QString("") && !line.isEmpty()) {
-        if(in.readLineInto(&line)) {;
+    while(lineSize > 0 && is_blank(line, lineSize)) {
+        if(in.readLine(line, lineSize)) {
             continue;
         } else {
             std::cerr << "error reading pgn file";
@@ -876,39 +799,33 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
         }
     }
 
+    if(this->m_movesOnly) {
+        return this->readMainline(in, line, lineSize, g);
+    }
+
     bool firstLine = true;
 
-    while (!in.atEnd() && !line.isEmpty()) {
-        if(line.trimmed().isEmpty()) {
-            return 0;
+    while (!in.atEnd() && lineSize > 0) {
+        if(is_blank(line, lineSize)) {
+            break;
         }
         // if we are at the first line after skipping
         // all the empty ones, don't read another line
-        // otherwise, call readLineInto
+        // otherwise, call readLine
         bool lineReadOk = true;
         if(!firstLine) {
-            lineReadOk = in.readLineInto(&line);
+            lineReadOk = in.readLine(line, lineSize);
         } else {
             firstLine = false;
         }
         if(lineReadOk) {
-            if(line.startsWith(QString::fromLatin1("%"))) {
+            if(lineSize > 0 && line[0] == '%') {
                 continue;
             }
             int idx = 0;
-            while(idx < line.size()) {
-                //if(idx + 6 << line.size()) {
-                    //qDebug() << line.mid(idx, 5);
-                    //std::cout << "TKN: " << line.mid(idx,5).toStdString() << std::endl;
-                    //assert(current != nullptr);
-                    //qDebug() << "null: "<< +(current == nullptr);
-                    //Board temp = *current->getBoard();
-                    //qDebug() << "got temp board";
-                    //qDebug() << "temp is null: "<< +(temp == nullptr);
-                    //std::cout << *current->getBoard() << std::endl;
-                //}
-
-                int tkn = getNetxtToken(line,idx);
+            while(idx < lineSize) {
+
+                int tkn = getNetxtToken(line, lineSize, idx);
                 if(tkn == TKN_EOL) {
                     break;
                 }
@@ -932,37 +849,11 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
                     g->setResult(RES_DRAW);
                     idx += 8;
                 }
-                if(tkn == TKN_PAWN_MOVE) {
-                    parsePawnMove(line,idx,current);
-                }
-                if(tkn == TKN_CASTLE) {
-                    parseCastleMove(line,idx,current);
-                }
-                if(tkn == TKN_ROOK_MOVE) {
-                    if(idx + 3 << line.size()) {
-                        //qDebug() << "ROOK: " << line.mid(idx, 4);
+                if(is_move_token(tkn)) {
+                    Move m;
+                    if(parseMove(tkn, line, lineSize, idx, current->getBoard(), m)) {
+                        addMove(current, m);
                     }
-                    parsePieceMove(ROOK,line,idx,current);
-                }
-                if(tkn == TKN_KNIGHT_MOVE) {
-                    //if(idx + 3 << line.size()) {
-                    //    qDebug() << "KNIGHT: " << line.mid(idx, 4);
-                    //}
-                    parsePieceMove(KNIGHT,line,idx,current);
-                    //std::cout << "after night move: ";
-                    //std::cout << std::endl << *current->getBoard() << std::endl;
-                }
-                if(tkn == TKN_BISHOP_MOVE) {
-                    //if(idx + 3 << line.size()) {
-                    //    qDebug() << "BISHOP: " << line.mid(idx, 4);
-                    //}
-                    parsePieceMove(BISHOP,line,idx,current);
-                }
-                if(tkn == TKN_QUEEN_MOVE) {
-                    parsePieceMove(QUEEN,line,idx,current);
-                }
-                if(tkn == TKN_KING_MOVE) {
-                    parsePieceMove(KING,line,idx,current);
                 }
                 if(tkn == TKN_CHECK) {
                     idx+=1;
@@ -976,9 +867,6 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
                     // put current node on stack, so that we don't forget it.
                     // however if we are at the root node, something
                     // is wrong in the PGN. Silently ignore "(" then
-                    //if(idx + 3 << line.size()) {
-                    //    qDebug() << "VARIATION: " << line.mid(idx, 4);
-                    //}
                     if(current != g->getRootNode()) {
                         m_game_stack.push(current);
                         current = current->getParent();
@@ -993,41 +881,40 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
                     idx+=1;
                 }
                 if(tkn == TKN_NAG) {
-                    //if(idx + 3 << line.size()) {
-                    //    qDebug() << "NAG" << line.mid(idx, 3);
-                    //}
-                    parseNAG(line, idx, current);
+                    parseNAG(line, lineSize, idx, current);
                 }
                 if(tkn == TKN_OPEN_COMMENT) {
-                    QStringRef rest_of_line = line.midRef(idx+1, line.size()-(idx+1));
-                    int end = rest_of_line.indexOf(QString::fromLatin1("}"));
-                    if(end >= 0) {
-                        QString comment_line = line.mid(idx+1, end);
-                        current->setComment(comment_line);
-                        idx = idx+end+1;
+                    // comments are kept as raw bytes, and
+                    // only decoded when they are accessed
+                    const char *rest = line + idx + 1;
+                    int rest_size = lineSize - (idx + 1);
+                    const char *end = static_cast<const char*>(std::memchr(rest, '}', size_t(rest_size)));
+                    if(end != 0) {
+                        int comment_size = int(end - rest);
+                        current->setRawComment(QByteArray(rest, comment_size), isUtf8);
+                        idx = idx + comment_size + 1;
                     } else {
                         // get comment over multiple lines
-                        QStringList comment_lines;
-                        QString comment_line = line.mid(idx+1, line.size() - (idx+1));
-                        comment_lines.append(comment_line);
+                        QByteArray comment(rest, rest_size);
                         // we already have the comment part of the current line,
                         // so read-in the next line, and then loop until we find
                         // the end marker "}"
                         int linesRead = 0;
                         while(linesRead < 50) {
-                            bool readOK = in.readLineInto(&line);
+                            bool readOK = in.readLine(line, lineSize);
                             if(!readOK) {
                                 break;
                             } else {
-                                int end_index = line.indexOf(QString::fromLatin1("}"));
-                                if(end_index >= 0) {
-                                    comment_lines.append(line.mid(0, end_index));
-                                    QString comment_joined = comment_lines.join(QString::fromLatin1("\n"));
-                                    current->setComment(comment_joined);
+                                const char *close = static_cast<const char*>(std::memchr(line, '}', size_t(lineSize)));
+                                comment.append('\n');
+                                if(close != 0) {
+                                    int end_index = int(close - line);
+                                    comment.append(line, end_index);
+                                    current->setRawComment(comment, isUtf8);
                                     idx = end_index+1;
                                     break;
                                 } else {
-                                    comment_lines.append(line);
+                                    comment.append(line, lineSize);
                                     linesRead++;
                                 }
                             }
@@ -1035,8 +922,7 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
                         // if we have read 50 lines or more, we have not seen a closing
                         // bracket and thus don't have set the comment in the while loop
                         if(linesRead >= 50) {
-                            QString comment_joined = comment_lines.join(QString::fromLatin1("\n"));
-                            current->setComment(comment_joined);
+                            current->setRawComment(comment, isUtf8);
                         }
                     }
                 }
@@ -1047,20 +933,146 @@ int PgnReader::readGame(QTextStream& in, chess::Game* g) {
             return -1;
         }
     }
+    // drop the boards that are still cached at the
+    // ends of the lines, keep only the checkpoints
+    if(g->getCheckpointInterval() > 0) {
+        g->releaseBoards();
+    }
     return 0;
 }
 
-int PgnReader::readGame(QTextStream &in, qint64 offset, chess::Game *g) {
+int PgnReader::readMainline(PgnLineSource &in, const char *line, int lineSize, chess::Game *g) {
 
+    GameNode *current = g->getRootNode();
+    // with a callback, moves are applied to a local board only
+    bool withNodes = !this->m_moveCallback;
+    Board board;
+    if(!withNodes) {
+        board = *current->getBoard();
+    }
+    // nesting depth of the variation that is skipped,
+    // and whether we are inside a comment
+    int depth = 0;
+    bool inComment = false;
+    bool stopped = false;
+    bool firstLine = true;
 
-    if(offset != 0 && offset > 0) {
-        in.seek(offset);
+    while(!in.atEnd() && (lineSize > 0 || inComment)) {
+        // a comment may span empty lines
+        if(!inComment && is_blank(line, lineSize)) {
+            break;
+        }
+        bool lineReadOk = true;
+        if(!firstLine) {
+            lineReadOk = in.readLine(line, lineSize);
+        } else {
+            firstLine = false;
+        }
+        if(!lineReadOk) {
+            std::cerr << "error reading pgn file";
+            return -1;
+        }
+        if(!inComment && lineSize > 0 && line[0] == '%') {
+            continue;
+        }
+        int idx = 0;
+        while(idx < lineSize) {
+            if(inComment) {
+                const char *close = static_cast<const char*>(std::memchr(line + idx, '}', size_t(lineSize - idx)));
+                if(close == 0) {
+                    break;
+                }
+                idx = int(close - line) + 1;
+                inComment = false;
+                continue;
+            }
+            if(depth > 0) {
+                // in a side line, only nesting and comments matter
+                char c = line[idx];
+                if(c == '(') {
+                    depth++;
+                } else if(c == ')') {
+                    depth--;
+                } else if(c == '{') {
+                    inComment = true;
+                }
+                idx++;
+                continue;
+            }
+            int tkn = getNetxtToken(line, lineSize, idx);
+            if(tkn == TKN_EOL) {
+                break;
+            }
+            if(is_move_token(tkn) || tkn == TKN_NULL_MOVE) {
+                if(stopped) {
+                    // the callback doesn't want the rest of the game,
+                    // just look for the result
+                    idx += 1;
+                    continue;
+                }
+                Move m;
+                bool found = true;
+                if(tkn == TKN_NULL_MOVE) {
+                    idx += 2;
+                } else {
+                    Board *b = withNodes ? current->getBoard() : &board;
+                    found = parseMove(tkn, line, lineSize, idx, b, m);
+                }
+                if(found) {
+                    if(withNodes) {
+                        addMove(current, m);
+                    } else if(this->m_moveCallback(board, m)) {
+                        board.clear_history();
+                        board.apply(m);
+                    } else {
+                        stopped = true;
+                    }
+                }
+                continue;
+            }
+            switch(tkn) {
+            case TKN_RES_WHITE_WIN:
+                g->setResult(RES_WHITE_WINS);
+                idx += 4;
+                break;
+            case TKN_RES_BLACK_WIN:
+                g->setResult(RES_BLACK_WINS);
+                idx += 4;
+                break;
+            case TKN_RES_UNDEFINED:
+                g->setResult(RES_UNDEF);
+                idx += 2;
+                break;
+            case TKN_RES_DRAW:
+                g->setResult(RES_DRAW);
+                idx += 8;
+                break;
+            case TKN_OPEN_VARIATION:
+                depth = 1;
+                idx += 1;
+                break;
+            case TKN_OPEN_COMMENT:
+                inComment = true;
+                idx += 1;
+                break;
+            case TKN_NAG:
+                // $12, or suffixes like !?
+                idx += 1;
+                while(idx < lineSize && ((line[idx] >= '0' && line[idx] <= '9')
+                                         || line[idx] == '!' || line[idx] == '?')) {
+                    idx++;
+                }
+                break;
+            default:
+                // check signs and stray closing brackets
+                idx += 1;
+            }
+        }
     }
-    return this->readGame(in, g);
+    if(g->getCheckpointInterval() > 0) {
+        g->releaseBoards();
+    }
+    return 0;
 }
 
-
-
-
-
 }
@@ -24,10 +24,13 @@
 #include <QTextStream>
 #include <memory>
 #include <QStack>
+#include <functional>
 #include "game.h"
 
 namespace chess {
 
+class PgnLineSource;
+
 struct HeaderOffset
 {
     qint64 offset;
@@ -53,15 +56,65 @@ struct PgnHeaderOffset
     PgnHeader header;
 };
 
+/**
+ * @brief MoveCallback receives the main line moves of a game in moves-only
+ *        mode, cf. PgnReader::setMoveCallback(). board is the position
+ *        before move m. Return false to skip the rest of the game.
+ */
+typedef std::function<bool(const Board &board, const Move &m)> MoveCallback;
+
 class PgnReader
 {
 
 public:
 
+    PgnReader();
+
+    /**
+     * @brief setTrusted enables the trusted mode for pgn files that are known
+     *                   to be valid, e.g. our own exports. Then moves are
+     *                   resolved with the least possible effort, and neither
+     *                   moves nor the FEN start position are validated.
+     *                   Invalid games may then be read into wrong trees.
+     *                   Validation can be done later with Game::findIllegalMove().
+     *                   Off by default.
+     */
+    void setTrusted(bool trusted);
+    bool isTrusted();
+
+    /**
+     * @brief setMovesOnly enables the moves-only mode for jobs that need just
+     *                     the main line. Comments, NAGs and variations are then
+     *                     skipped on the byte level, and games consist of headers,
+     *                     result and the main line. Off by default.
+     */
+    void setMovesOnly(bool movesOnly);
+    bool isMovesOnly();
+
+    /**
+     * @brief setMoveCallback in moves-only mode, pass main line moves to callback
+     *                        instead of adding them to the game. Then no nodes are
+     *                        created at all, and the game just gets headers and
+     *                        result. An empty callback adds the moves again.
+     */
+    void setMoveCallback(const MoveCallback &callback);
+
     bool isUtf8(const QString &filename);
 
     QVector<qint64> scanPgn(QString &filename, bool isUtf8);
+
+    /**
+     * @brief scanPgn1 same as scanPgn, but reads and decodes the file
+     *        line by line. Much slower, kept as reference for tests
+     */
     QVector<qint64> scanPgn1(QString &filename, bool is_utf8);
+
+    /**
+     * @brief scanPgnIndexed same as scanPgn, but uses (and updates)
+     *        the sidecar index of the file, cf. PgnIndex. Only scans
+     *        if the file is new, has changed or was appended to.
+     */
+    QVector<qint64> scanPgnIndexed(QString &filename, bool isUtf8);
     PgnHeader readSingleHeaderFromPgnAt(QString &filename, qint64 offset, bool isUtf8);
 
     int readGameFromString(QString &pgn_string, chess::Game *g);
@@ -70,35 +123,62 @@ public:
     int readGame(QTextStream& in, chess::Game* g);
     int readGame(QTextStream &in, qint64 offset, chess::Game *g);
 
+    /**
+     * @brief readGame parses the game at the beginning of a raw
+     *        byte buffer, e.g. a memory mapped pgn file at some
+     *        game offset. Comments and header values are stored
+     *        undecoded and only converted once they are accessed.
+     * @param data start of the game
+     * @param len number of bytes available after data
+     * @param isUtf8 encoding of the bytes, otherwise latin1
+     * @param g game to read into
+     * @return 0 on success, -1 on error
+     */
+    int readGame(const char *data, qint64 len, bool isUtf8, chess::Game *g);
+
 
 private:
 
     QStack<GameNode*> m_game_stack;
+    // game that is currently read, owns the new nodes
+    Game *m_game;
+    bool m_trusted;
+    bool m_movesOnly;
+    MoveCallback m_moveCallback;
 
     inline void addMove(GameNode *&node, Move &m);
 
-    // these functions expect a qstring and an offset
+    int readGame(PgnLineSource &in, bool isUtf8, chess::Game *g);
+
+    // move text in moves-only mode, starting with line
+    int readMainline(PgnLineSource &in, const char *line, int lineSize, chess::Game *g);
+
+    // these functions expect a line (as raw bytes) and an offset
     // where the (move) token start. they will parse
     // the token, return true, and set idx to the offset
     // after the token. If the token cannot be parsed
     // they will return false
-    inline bool isCol(const QChar &c);
-    inline bool isRow(const QChar &c);
+    inline bool isCol(char c);
+    inline bool isRow(char c);
+
+    // parses the move token tkn (one of TKN_PAWN_MOVE ... TKN_KING_MOVE)
+    // in the position of board, and sets move. does not apply the move
+    bool parseMove(int tkn, const char *line, int lineSize, int &idx, Board *board, Move &move);
 
-    bool parsePawnMove(QString &line, int &idx, GameNode *&node);
-    bool parsePieceMove(uint8_t piece_type, const QString &line, int &idx, GameNode *&node);
-    bool parseCastleMove(QString &line, int &idx, GameNode *&node);
+    bool parsePawnMove(const char *line, int lineSize, int &idx, Board *board, Move &move);
+    bool parsePieceMove(uint8_t piece_type, const char *line, int lineSize, int &idx, Board *board, Move &move);
+    bool parseCastleMove(const char *line, int lineSize, int &idx, Board *board, Move &move);
 
-    bool createPieceMove(uint8_t piece_type, int to_col, int to_row, GameNode *&node);
-    bool createPieceMove(uint8_t piece_type, int to_col, int to_row, GameNode *&node, QChar col_from);
-    bool createPieceMove(uint8_t piece_type, int to_col, int to_row, GameNode *&node, int from_row);
+    // from_col and from_row are -1 if the san has no disambiguation
+    bool createPieceMove(uint8_t piece_type, int from_col, int from_row,
+                         int to_col, int to_row, Board *board, Move &move);
 
-    void parseNAG(QString &line, int &idx, GameNode *node);
+    void parseNAG(const char *line, int lineSize, int &idx, GameNode *node);
 
     // seeks to the next token in line, and sets
     // idx to the start of the new token
     // returns the token type, i.e. one of TKN_*
-    int getNetxtToken(QString &line, int &idx);
+    int getNetxtToken(const char *line, int lineSize, int &idx);
 
 };
 
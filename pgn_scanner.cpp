@@ -0,0 +1,560 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "pgn_scanner.h"
+#include "bitboard.h"
+#include <QFile>
+#include <QByteArray>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PGN_SCANNER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang only emit AVX2 instructions in functions
+// that are explicitly compiled for that target
+#if defined(__GNUC__)
+#define PGN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PGN_TARGET_AVX2
+#endif
+
+namespace chess {
+
+// block size if the file can't be mapped
+static const qint64 SCAN_BLOCK_SIZE = 4 * 1024 * 1024;
+// files are only split into parts of at least this size, smaller
+// ones are not worth the overhead of starting threads
+static const qint64 SCAN_MIN_PART_SIZE = 16 * 1024 * 1024;
+
+static void classify_scalar(const char *block, PgnMasks &m) {
+    m.newline = 0;
+    m.bracket = 0;
+    m.open_brace = 0;
+    m.close_brace = 0;
+    m.percent = 0;
+    for(int i=0;i<64;i++) {
+        quint64 bit = Q_UINT64_C(1) << i;
+        switch(block[i]) {
+        case '\n':
+            m.newline |= bit;
+            break;
+        case '[':
+            m.bracket |= bit;
+            break;
+        case '{':
+            m.open_brace |= bit;
+            break;
+        case '}':
+            m.close_brace |= bit;
+            break;
+        case '%':
+            m.percent |= bit;
+            break;
+        }
+    }
+}
+
+#if defined(PGN_SCANNER_X86)
+
+// SSE2 is part of every x86-64 cpu
+static void classify_sse2(const char *block, PgnMasks &m) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i br = _mm_set1_epi8('[');
+    const __m128i ob = _mm_set1_epi8('{');
+    const __m128i cb = _mm_set1_epi8('}');
+    const __m128i pc = _mm_set1_epi8('%');
+    m.newline = 0;
+    m.bracket = 0;
+    m.open_brace = 0;
+    m.close_brace = 0;
+    m.percent = 0;
+    for(int i=0;i<4;i++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        int shift = 16 * i;
+        m.newline |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))) << shift;
+        m.bracket |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, br)))) << shift;
+        m.open_brace |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, ob)))) << shift;
+        m.close_brace |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, cb)))) << shift;
+        m.percent |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, pc)))) << shift;
+    }
+}
+
+PGN_TARGET_AVX2
+static void classify_avx2(const char *block, PgnMasks &m) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i br = _mm256_set1_epi8('[');
+    const __m256i ob = _mm256_set1_epi8('{');
+    const __m256i cb = _mm256_set1_epi8('}');
+    const __m256i pc = _mm256_set1_epi8('%');
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    m.newline = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl))))
+            | (quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl)))) << 32);
+    m.bracket = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, br))))
+            | (quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, br)))) << 32);
+    m.open_brace = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, ob))))
+            | (quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, ob)))) << 32);
+    m.close_brace = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, cb))))
+            | (quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, cb)))) << 32);
+    m.percent = quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, pc))))
+            | (quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, pc)))) << 32);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // the os must save ymm registers on context switches
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if(!osxsave || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+struct ClassifyKernel
+{
+    ClassifyFunc func;
+    const char *name;
+};
+
+// all kernels the cpu supports, the fastest one last
+static QVector<ClassifyKernel> supported_kernels() {
+    QVector<ClassifyKernel> kernels;
+    ClassifyKernel k;
+    k.func = classify_scalar;
+    k.name = "scalar";
+    kernels.append(k);
+#if defined(PGN_SCANNER_X86)
+    k.func = classify_sse2;
+    k.name = "sse2";
+    kernels.append(k);
+    if(cpu_has_avx2()) {
+        k.func = classify_avx2;
+        k.name = "avx2";
+        kernels.append(k);
+    }
+#endif
+    return kernels;
+}
+
+// cpu detection runs only once, also if
+// several threads start scanning concurrently
+static const QVector<ClassifyKernel>& kernels() {
+    static const QVector<ClassifyKernel> k = supported_kernels();
+    return k;
+}
+
+static const ClassifyKernel& kernel() {
+    return kernels().last();
+}
+
+const char* PgnScanner::kernelName() {
+    return kernel().name;
+}
+
+QVector<const char*> PgnScanner::kernelNames() {
+    QVector<const char*> names;
+    for(int i=0;i<kernels().size();i++) {
+        names.append(kernels().at(i).name);
+    }
+    return names;
+}
+
+bool PgnScanner::setKernel(const char *name) {
+    for(int i=0;i<kernels().size();i++) {
+        if(std::strcmp(kernels().at(i).name, name) == 0) {
+            this->classify = kernels().at(i).func;
+            return true;
+        }
+    }
+    return false;
+}
+
+PgnScanner::PgnScanner(bool is_utf8) {
+    this->classify = kernel().func;
+    this->is_utf8 = is_utf8;
+    this->in_comment = false;
+    this->game_pos = -1;
+    this->last_pos = 0;
+    this->pos = 0;
+    this->has_body = false;
+    this->line_first = 0;
+    this->line_has_open = false;
+    this->line_has_close = false;
+    this->line_last_open = false;
+}
+
+PgnScanner::PgnScanner(bool is_utf8, qint64 offset, bool in_comment) {
+    this->classify = kernel().func;
+    this->is_utf8 = is_utf8;
+    this->in_comment = in_comment;
+    this->game_pos = -1;
+    this->last_pos = offset == 0 ? 0 : INHERITED;
+    this->pos = offset;
+    this->has_body = false;
+    this->line_first = 0;
+    this->line_has_open = false;
+    this->line_has_close = false;
+    this->line_last_open = false;
+}
+
+PgnScanner PgnScanner::atGame(bool is_utf8, qint64 offset) {
+    // at a game offset, the scanner is outside of any comment, and the
+    // previous game (if any) has already been recorded. only '%' lines
+    // can be between offset and the first header line
+    PgnScanner scanner(is_utf8);
+    scanner.pos = offset;
+    scanner.last_pos = offset;
+    return scanner;
+}
+
+bool PgnScanner::inComment() const {
+    return this->in_comment;
+}
+
+// called at the end of each line. next_pos is
+// the file offset after the terminating newline
+void PgnScanner::endLine(qint64 next_pos) {
+
+    char first = this->line_first;
+    bool has_open = this->line_has_open;
+    bool has_close = this->line_has_close;
+    bool last_open = this->line_last_open;
+    this->line_first = 0;
+    this->line_has_open = false;
+    this->line_has_close = false;
+    this->line_last_open = false;
+
+    // skip comments. note that last_pos is not updated here
+    if(first == '%') {
+        return;
+    }
+
+    if(!this->in_comment && first == '[') {
+        if(this->game_pos == -1) {
+            this->game_pos = this->last_pos;
+        }
+        this->last_pos = next_pos;
+        return;
+    }
+
+    // the line only changes the comment state if it contains
+    // an opening (resp. closing) brace. the new state is then
+    // determined by which brace comes last in the line
+    if((!this->in_comment && has_open) || (this->in_comment && has_close)) {
+        this->in_comment = last_open;
+    }
+
+    if(this->game_pos != -1) {
+        this->offsets.append(this->game_pos);
+        this->game_pos = -1;
+    }
+    this->last_pos = next_pos;
+    this->has_body = true;
+}
+
+// processes the first valid bytes of the block at this->pos
+void PgnScanner::scanBlock(const PgnMasks &m, int valid) {
+
+    quint64 newlines = m.newline;
+    int start = 0;
+    while(start < valid) {
+        int eol = newlines ? lsb(newlines) : valid;
+        if(this->line_first == 0 && start < eol) {
+            quint64 bit = Q_UINT64_C(1) << start;
+            if(m.percent & bit) {
+                this->line_first = '%';
+            } else if(m.bracket & bit) {
+                this->line_first = '[';
+            } else {
+                this->line_first = ' ';
+            }
+        }
+        // braces in [start, eol)
+        quint64 range = (BB_ALL << start);
+        if(eol < 64) {
+            range &= (Q_UINT64_C(1) << eol) - 1;
+        }
+        quint64 open = m.open_brace & range;
+        quint64 close = m.close_brace & range;
+        if(open | close) {
+            this->line_has_open |= open != 0;
+            this->line_has_close |= close != 0;
+            // masks are disjoint, so the larger one
+            // contains the highest, i.e. last brace
+            this->line_last_open = open > close;
+        }
+        if(newlines == 0) {
+            break;
+        }
+        this->endLine(this->pos + eol + 1);
+        newlines &= newlines - 1;
+        start = eol + 1;
+    }
+    this->pos += valid;
+}
+
+void PgnScanner::scan(const char *data, qint64 len) {
+
+    // QString::fromUtf8 drops the byte order mark, so
+    // the first line is classified after it
+    if(this->pos == 0 && this->is_utf8 && len >= 3
+            && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        len -= 3;
+        this->pos = 3;
+    }
+
+    ClassifyFunc classify = this->classify;
+    PgnMasks m;
+    qint64 i = 0;
+    for(;i + 64 <= len;i += 64) {
+        classify(data + i, m);
+        this->scanBlock(m, 64);
+    }
+    if(i < len) {
+        // pad the rest with bytes that match nothing
+        char tail[64];
+        std::memset(tail, 0, sizeof(tail));
+        std::memcpy(tail, data + i, size_t(len - i));
+        classify(tail, m);
+        this->scanBlock(m, int(len - i));
+    }
+}
+
+void PgnScanner::join(const PgnScanner &next) {
+
+    // parts are split at line starts
+    Q_ASSERT(this->line_first == 0);
+
+    // before its first body line, next only saw header and '%' lines.
+    // for these, this scanner's pending game start (if any) wins.
+    // otherwise a game starts at the inherited position
+    if(next.has_body) {
+        QVector<qint64> next_offsets = next.offsets;
+        if(!next_offsets.isEmpty() && next_offsets.at(0) == INHERITED) {
+            next_offsets[0] = this->game_pos != -1 ? this->game_pos : this->last_pos;
+        } else if(this->game_pos != -1) {
+            next_offsets.prepend(this->game_pos);
+        }
+        this->offsets += next_offsets;
+        this->game_pos = next.game_pos;
+        this->last_pos = next.last_pos;
+        this->has_body = true;
+    } else {
+        if(this->game_pos == -1 && next.game_pos == INHERITED) {
+            this->game_pos = this->last_pos;
+        }
+        if(next.last_pos != INHERITED) {
+            this->last_pos = next.last_pos;
+        }
+    }
+    this->in_comment = next.in_comment;
+    this->pos = next.pos;
+    this->line_first = next.line_first;
+    this->line_has_open = next.line_has_open;
+    this->line_has_close = next.line_has_close;
+    this->line_last_open = next.line_last_open;
+}
+
+QVector<qint64> PgnScanner::takeOffsets() {
+    QVector<qint64> found = this->offsets;
+    this->offsets.clear();
+    return found;
+}
+
+qint64 PgnScanner::pendingStart() const {
+    if(this->game_pos != -1) {
+        return this->game_pos;
+    }
+    return this->last_pos;
+}
+
+QVector<qint64> PgnScanner::finish() {
+    // a last line without newline
+    if(this->line_first != 0) {
+        this->endLine(this->pos);
+    }
+    // for the last game
+    if(this->game_pos != -1) {
+        this->offsets.append(this->game_pos);
+        this->game_pos = -1;
+    }
+    return this->offsets;
+}
+
+class PgnScanTask : public QRunnable
+{
+
+public:
+    PgnScanTask(PgnScanner *scanner, const char *data, qint64 len)
+        : scanner(scanner), data(data), len(len) {}
+
+    void run() {
+        this->scanner->scan(this->data, this->len);
+    }
+
+private:
+    PgnScanner *scanner;
+    const char *data;
+    qint64 len;
+
+};
+
+static QVector<qint64> scan_parallel(const char *data, qint64 offset, qint64 size,
+                                     bool is_utf8, int parts, const char *kernel_name) {
+
+    // split at line starts, i.e. after the first
+    // newline that follows an even split point
+    QVector<qint64> bounds;
+    bounds.append(offset);
+    for(int i=1;i<parts;i++) {
+        qint64 from = qMax(offset + (size - offset) / parts * i, bounds.last());
+        const char *nl = static_cast<const char*>(std::memchr(data + from, '\n', size_t(size - from)));
+        if(nl == 0) {
+            break;
+        }
+        bounds.append(qint64(nl - data) + 1);
+    }
+    bounds.append(size);
+
+    // all parts except the first are scanned assuming they start
+    // outside of a comment. that is almost always the case
+    QVector<PgnScanner*> scanners;
+    scanners.append(new PgnScanner(PgnScanner::atGame(is_utf8, offset)));
+    for(int i=1;i<bounds.size()-1;i++) {
+        scanners.append(new PgnScanner(is_utf8, bounds.at(i), false));
+    }
+    if(kernel_name != 0) {
+        for(int i=0;i<scanners.size();i++) {
+            scanners.at(i)->setKernel(kernel_name);
+        }
+    }
+    QThreadPool pool;
+    pool.setMaxThreadCount(scanners.size());
+    for(int i=0;i<scanners.size();i++) {
+        pool.start(new PgnScanTask(scanners.at(i), data + bounds.at(i), bounds.at(i+1) - bounds.at(i)));
+    }
+    pool.waitForDone();
+
+    // if a comment actually spans a split point,
+    // the part after it is scanned again
+    PgnScanner *result = scanners.at(0);
+    for(int i=1;i<scanners.size();i++) {
+        PgnScanner *next = scanners.at(i);
+        if(result->inComment()) {
+            delete next;
+            next = new PgnScanner(is_utf8, bounds.at(i), true);
+            if(kernel_name != 0) {
+                next->setKernel(kernel_name);
+            }
+            next->scan(data + bounds.at(i), bounds.at(i+1) - bounds.at(i));
+            scanners[i] = next;
+        }
+        result->join(*next);
+    }
+    QVector<qint64> offsets = result->finish();
+    qDeleteAll(scanners);
+    return offsets;
+}
+
+QVector<qint64> scanPgnFile(const QString &filename, bool is_utf8) {
+    return scanPgnFile(filename, is_utf8, 0);
+}
+
+QVector<qint64> scanPgnFile(const QString &filename, bool is_utf8, qint64 offset) {
+
+    PgnScanner scanner = PgnScanner::atGame(is_utf8, offset);
+    QFile file(filename);
+
+    if(!file.open(QIODevice::ReadOnly)) {
+        return QVector<qint64>();
+    }
+    qint64 size = file.size();
+    if(offset < 0 || offset >= size) {
+        return QVector<qint64>();
+    }
+
+    uchar *mapped = file.map(0, size);
+    if(mapped != 0) {
+        int parts = int(qMin(qint64(QThread::idealThreadCount()), (size - offset) / SCAN_MIN_PART_SIZE));
+        QVector<qint64> offsets;
+        if(parts > 1) {
+            offsets = scan_parallel(reinterpret_cast<const char*>(mapped), offset, size, is_utf8, parts, 0);
+        } else {
+            scanner.scan(reinterpret_cast<const char*>(mapped) + offset, size - offset);
+            offsets = scanner.finish();
+        }
+        file.unmap(mapped);
+        return offsets;
+    }
+
+    // mapping may fail, e.g. for huge files on 32 bit
+    // systems or for special files. then read blocks
+    if(!file.seek(offset)) {
+        return QVector<qint64>();
+    }
+    for(;;) {
+        QByteArray block = file.read(SCAN_BLOCK_SIZE);
+        if(block.isEmpty()) {
+            break;
+        }
+        scanner.scan(block.constData(), block.size());
+    }
+    return scanner.finish();
+}
+
+QVector<qint64> scanPgnData(const char *data, qint64 size, bool is_utf8,
+                            int parts, const char *kernel) {
+
+    PgnScanner scanner(is_utf8);
+    if(kernel != 0 && !scanner.setKernel(kernel)) {
+        return QVector<qint64>();
+    }
+    if(parts > 1 && size > 0) {
+        return scan_parallel(data, 0, size, is_utf8, parts, kernel);
+    }
+    scanner.scan(data, size);
+    return scanner.finish();
+}
+
+}
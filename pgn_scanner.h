@@ -0,0 +1,216 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef PGN_SCANNER_H
+#define PGN_SCANNER_H
+
+#include <QVector>
+#include <QString>
+
+namespace chess {
+
+/**
+ * @brief PgnMasks classification of a block of 64 bytes. Bit n
+ *        of each mask is set, if byte n of the block is the
+ *        respective character.
+ */
+struct PgnMasks
+{
+    quint64 newline;
+    quint64 bracket;
+    quint64 open_brace;
+    quint64 close_brace;
+    quint64 percent;
+};
+
+typedef void (*ClassifyFunc)(const char *block, PgnMasks &m);
+
+/**
+ * @brief PgnScanner finds the start offsets of all games in a pgn file.
+ *        It works directly on the raw bytes of the file, and does neither
+ *        copy nor decode lines. All characters that matter ('[', '{', '}',
+ *        '%' and newline) are plain ASCII, so this gives the very same
+ *        offsets for UTF-8 and ISO 8859-1 encoded files.
+ *
+ *        Rules are exactly those of the line based scanner that was used
+ *        before: a line starting with '[' outside of a comment is a header
+ *        line, and a game starts at the first header line after a non-header
+ *        line. Lines starting with '%' are ignored; they do not even count as
+ *        a line that separates the preceding from the next game start.
+ *
+ *        Input is classified in blocks of 64 bytes into bitmasks (with
+ *        AVX2 or SSE2 if the cpu supports it), and lines are then
+ *        processed on these masks, i.e. without looking at single bytes.
+ *
+ *        Large files are split into parts at line starts, and each part
+ *        is scanned by its own PgnScanner. Results are then combined
+ *        with join().
+ */
+class PgnScanner
+{
+
+public:
+    PgnScanner(bool is_utf8);
+
+    /**
+     * @brief PgnScanner scanner that resumes scanning at a game offset,
+     *        e.g. to rescan the tail of a file that was appended to.
+     *        Gives the same result for the rest of the file as a
+     *        scanner that started at the beginning.
+     * @param offset game offset found by a previous scan, or 0
+     */
+    static PgnScanner atGame(bool is_utf8, qint64 offset);
+
+    /**
+     * @brief PgnScanner scanner for a part of the file
+     * @param offset file offset where the part starts. must be a line start
+     * @param in_comment comment state at that offset
+     */
+    PgnScanner(bool is_utf8, qint64 offset, bool in_comment);
+
+    /**
+     * @brief scan processes the next part of the file. Consecutive calls
+     *             must supply consecutive parts, starting at offset 0.
+     *             Parts may end anywhere, also within a line.
+     * @param data file content
+     * @param len length of data
+     */
+    void scan(const char *data, qint64 len);
+
+    /**
+     * @brief join takes over the result of a scanner for the directly
+     *             following part of the file. That scanner must have been
+     *             started with the comment state this scanner ends in.
+     *             Afterwards this scanner is in the same state as if it
+     *             had scanned both parts itself.
+     */
+    void join(const PgnScanner &next);
+
+    /**
+     * @brief inComment true if the scanned bytes end within a comment
+     */
+    bool inComment() const;
+
+    /**
+     * @brief takeOffsets returns the game offsets found so far, and
+     *                    removes them from the scanner. A game start is
+     *                    found once the first line after its headers is
+     *                    scanned. Not to be used with join()
+     */
+    QVector<qint64> takeOffsets();
+
+    /**
+     * @brief pendingStart the smallest offset at which a game that is
+     *                     not found yet may start. Bytes before it are
+     *                     not needed anymore to read later games. Only
+     *                     for scanners that started at a game offset
+     */
+    qint64 pendingStart() const;
+
+    /**
+     * @brief finish processes a last line without terminating newline, and
+     *               returns the game offsets. A game whose headers reach
+     *               up to the end of file is included.
+     */
+    QVector<qint64> finish();
+
+    /**
+     * @brief kernelName name of the classification kernel
+     *                   selected for this cpu, i.e. avx2, sse2 or scalar
+     */
+    static const char* kernelName();
+
+    /**
+     * @brief kernelNames names of all classification kernels
+     *                    this cpu supports, e.g. to test each of them
+     */
+    static QVector<const char*> kernelNames();
+
+    /**
+     * @brief setKernel selects the classification kernel of this scanner,
+     *                  instead of the fastest one the cpu supports
+     * @param name one of kernelNames()
+     * @return false if the cpu doesn't support the kernel
+     */
+    bool setKernel(const char *name);
+
+private:
+    ClassifyFunc classify;
+    bool is_utf8;
+    bool in_comment;
+    qint64 game_pos;
+    qint64 last_pos;
+    // file offset of the next byte to scan
+    qint64 pos;
+    // true once a line that is neither a header nor a '%' line is seen.
+    // until then a part scanner does not know where the previous
+    // game ended, and uses INHERITED in place of that position
+    bool has_body;
+    QVector<qint64> offsets;
+
+    // state of the current line. line_first is the first byte, and
+    // zero as long as the line is empty. last_open is true if the last
+    // brace in the line is an opening one
+    char line_first;
+    bool line_has_open;
+    bool line_has_close;
+    bool line_last_open;
+
+    static const qint64 INHERITED = -2;
+
+    inline void scanBlock(const PgnMasks &m, int valid);
+    inline void endLine(qint64 next_pos);
+
+};
+
+/**
+ * @brief scanPgnFile scans the whole file with a PgnScanner. The file
+ *                    is memory mapped if possible, and read blockwise
+ *                    otherwise. Large mapped files are split into one
+ *                    part per core, and parts are scanned concurrently.
+ * @return start offsets of all games, empty if the file can't be opened
+ */
+QVector<qint64> scanPgnFile(const QString &filename, bool is_utf8);
+
+/**
+ * @brief scanPgnFile scans the file from offset on, like
+ *                    PgnScanner::atGame()
+ * @param offset game offset found by a previous scan, or 0
+ * @return offsets of the games at or after offset
+ */
+QVector<qint64> scanPgnFile(const QString &filename, bool is_utf8, qint64 offset);
+
+/**
+ * @brief scanPgnData scans file content that is already in memory, split
+ *                    into parts that are scanned concurrently like those
+ *                    of a large file. Mainly to test the split with small
+ *                    inputs
+ * @param parts number of parts, 1 scans sequentially
+ * @param kernel classification kernel, cf. PgnScanner::setKernel(). null
+ *               selects the fastest one
+ * @return start offsets of all games, empty if the kernel isn't supported
+ */
+QVector<qint64> scanPgnData(const char *data, qint64 size, bool is_utf8,
+                            int parts, const char *kernel = 0);
+
+}
+
+#endif // PGN_SCANNER_H
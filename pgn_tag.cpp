@@ -0,0 +1,166 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#include "pgn_tag.h"
+#include <cstring>
+
+namespace chess {
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+// letters, digits and underscore, cf. pgn standard 8.1.1
+static inline bool is_name_char(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+            || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool PgnTagPair::nameEquals(const char *s) const {
+    int len = int(std::strlen(s));
+    return len == this->nameSize && std::memcmp(this->name, s, size_t(len)) == 0;
+}
+
+QString PgnTagPair::nameString() const {
+    return QString::fromLatin1(this->name, this->nameSize);
+}
+
+QByteArray PgnTagPair::valueBytes() const {
+    if(!this->escaped) {
+        return QByteArray(this->value, this->valueSize);
+    }
+    QByteArray bytes;
+    bytes.reserve(this->valueSize);
+    for(int i=0;i<this->valueSize;i++) {
+        char c = this->value[i];
+        if(c == '\\' && i+1 < this->valueSize
+                && (this->value[i+1] == '"' || this->value[i+1] == '\\')) {
+            i++;
+            c = this->value[i];
+        }
+        bytes.append(c);
+    }
+    return bytes;
+}
+
+QString PgnTagPair::valueString(bool isUtf8) const {
+    QByteArray bytes = this->valueBytes();
+    if(isUtf8) {
+        return QString::fromUtf8(bytes);
+    } else {
+        return QString::fromLatin1(bytes);
+    }
+}
+
+// scans the value that starts at i, and sets tag and idx if it is
+// properly closed. with use_escapes == false, backslashes are
+// taken literally
+static bool scan_value(const char *line, int size, int i, bool use_escapes,
+                       int name_start, int name_end, int &idx, PgnTagPair &tag) {
+    int value_start = i;
+    bool escaped = false;
+    // the quote that ends the value. quotes
+    // that are not followed by ] are part of it
+    while(i < size) {
+        char c = line[i];
+        if(c == '\\' && use_escapes) {
+            escaped = true;
+            i += 2;
+            continue;
+        }
+        if(c == '"') {
+            int j = i + 1;
+            while(j < size && is_space(line[j])) {
+                j++;
+            }
+            if(j < size && line[j] == ']') {
+                tag.name = line + name_start;
+                tag.nameSize = name_end - name_start;
+                tag.value = line + value_start;
+                tag.valueSize = i - value_start;
+                tag.escaped = escaped;
+                idx = j + 1;
+                return true;
+            }
+            i = j;
+            continue;
+        }
+        i++;
+    }
+    return false;
+}
+
+bool scanTagPair(const char *line, int size, int &idx, PgnTagPair &tag) {
+
+    int i = idx;
+    while(i < size && is_space(line[i])) {
+        i++;
+    }
+    if(i >= size || line[i] != '[') {
+        return false;
+    }
+    i++;
+    while(i < size && is_space(line[i])) {
+        i++;
+    }
+    int name_start = i;
+    while(i < size && is_name_char(line[i])) {
+        i++;
+    }
+    if(i == name_start) {
+        return false;
+    }
+    int name_end = i;
+    while(i < size && is_space(line[i])) {
+        i++;
+    }
+    if(i >= size || line[i] != '"') {
+        return false;
+    }
+    i++;
+    if(scan_value(line, size, i, true, name_start, name_end, idx, tag)) {
+        return true;
+    }
+    // a value that ends with a single backslash, like a
+    // windows path "C:\", is not escaped at all
+    if(std::memchr(line + i, '\\', size_t(size - i)) != 0) {
+        return scan_value(line, size, i, false, name_start, name_end, idx, tag);
+    }
+    return false;
+}
+
+QString escapeTagValue(const QString &value) {
+    if(!value.contains(QChar::fromLatin1('"')) && !value.contains(QChar::fromLatin1('\\'))) {
+        return value;
+    }
+    QString escaped;
+    escaped.reserve(value.size() + 2);
+    for(int i=0;i<value.size();i++) {
+        QChar c = value.at(i);
+        if(c == QChar::fromLatin1('"') || c == QChar::fromLatin1('\\')) {
+            escaped.append(QChar::fromLatin1('\\'));
+        }
+        escaped.append(c);
+    }
+    return escaped;
+}
+
+}
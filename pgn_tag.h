@@ -0,0 +1,96 @@
+/* Jerry - A Chess Graphical User Interface
+ * Copyright (C) 2014-2016 Dominik Klein
+ * Copyright (C) 2015-2016 Karl Josef Klein
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+
+#ifndef PGN_TAG_H
+#define PGN_TAG_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace chess {
+
+/**
+ * @brief PgnTagPair a tag pair like [Event "F/S Return Match"]
+ *        of a pgn header line. Name and value point into the
+ *        line that was scanned, i.e. nothing is copied or decoded.
+ *        The value is the raw text between the quotes, including
+ *        escape sequences (\" and \\) if any.
+ */
+struct PgnTagPair
+{
+    const char *name;
+    int nameSize;
+    const char *value;
+    int valueSize;
+    // true if value contains at least one backslash
+    bool escaped;
+
+    /**
+     * @brief nameEquals compares the tag name to the
+     *        (zero terminated) name s
+     */
+    bool nameEquals(const char *s) const;
+
+    /**
+     * @brief nameString tag name as string. Names are ASCII.
+     */
+    QString nameString() const;
+
+    /**
+     * @brief valueBytes tag value with escape sequences resolved
+     */
+    QByteArray valueBytes() const;
+
+    /**
+     * @brief valueString decoded tag value with escape sequences resolved
+     * @param isUtf8 encoding of the value, otherwise latin1
+     */
+    QString valueString(bool isUtf8) const;
+};
+
+/**
+ * @brief scanTagPair scans a tag pair of a pgn header line. Leading
+ *        whitespace is skipped, and idx is set to the first character
+ *        after the closing bracket, so that several tag pairs in one
+ *        line can be scanned with subsequent calls.
+ *
+ *        Runs in linear time. The value ends at the first quote that is
+ *        followed by (optional whitespace and) the closing bracket, so
+ *        values with unescaped quotes like "The "Immortal" Game" that
+ *        are found in the wild are still accepted.
+ * @param line bytes of the line
+ * @param size number of bytes in line
+ * @param idx start position of the scan. After a successful scan,
+ *        the position after the tag pair
+ * @param tag set to the found tag pair
+ * @return true, if a tag pair was found at idx. Otherwise idx is unchanged
+ */
+bool scanTagPair(const char *line, int size, int &idx, PgnTagPair &tag);
+
+/**
+ * @brief escapeTagValue adds escape sequences to value, so
+ *        that it can be written as tag value in a pgn file
+ */
+QString escapeTagValue(const QString &value);
+
+}
+
+#endif // PGN_TAG_H
@@ -1,196 +1,728 @@
 #include "testcases.h"
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QDebug>
 #include "board.h"
+#include "perft.h"
+#include "pgn_reader.h"
+#include "pgn_scanner.h"
+#include "pgn_printer.h"
+#include "pgn_bulk_reader.h"
+#include "pgn_index.h"
+#include "pgn_header_table.h"
+#include "game_db.h"
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QTextCodec>
+#include <QDataStream>
 #include <iostream>
 
 chess::TestCases::TestCases()
 {
 }
 
-int chess::TestCases::count_moves(Board b, int depth) {
-
-    int count = 0;
-    QVector<Move> mvs = b.legal_moves();
-    for(int i=0;i<mvs.count();i++) {
-        Move mi = mvs.at(i);
-        QString mv_uci = mi.uci();
-        //qDebug() << "foo: "<< mv_uci;
-    }
-    if(depth == 0) {
-        int cnt = mvs.count();
-        return cnt;
-    } else {
-        // recursive case: for each possible move, apply
-        // the move, do the recursive call and undo the move
-        for(int i=0;i<mvs.count();i++) {
-            Move m = mvs.at(i);
-            // /QString old_fen = b.fen();
-            b.apply(m);
-            int cnt_i = count_moves(b, depth - 1);
-            count += cnt_i;
+void chess::TestCases::run_pertf() {
+
+    struct PerftCase {
+        const char *fen;
+        int depth;
+        quint64 expected;
+    };
+
+    PerftCase cases[] = {
+        // perft 0 is just the position itself
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0, 1 },
+        // initial position tests, perft 1 - 6
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 1, 20 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 2, 400 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 3, 8902 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609 },
+        // "Kiwipete" by Peter McKenzie, great for identifying bugs
+        // perft 1 - 5
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0", 1, 48 },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0", 2, 2039 },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0", 3, 97862 },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0", 4, 4085603 },
+        // some more pos. for bug-hunting, taken from chessprogramming wiki and
+        // Sharper by Albert Bertilsson's homepage
+        // perft 1 - 2
+        { "8/3K4/2p5/p2b2r1/5k2/8/8/1q6 b - - 1 67", 1, 50 },
+        { "8/3K4/2p5/p2b2r1/5k2/8/8/1q6 b - - 1 67", 2, 279 },
+        // perft 5
+        { "rnbqkb1r/ppppp1pp/7n/4Pp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 5, 11139762 },
+        // perft 1 - 5
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 1, 44 },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 2, 1486 },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379 },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487 },
+        // most computational intensive (i.e. deepest) of the above
+        // are at the end here
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194 },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324 },
+        // perft 6
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 0", 6, 11030083 },
+        // perft 7
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 0", 7, 178633661 },
+        // perft 6
+        { "8/7p/p5pb/4k3/P1pPn3/8/P5PP/1rB2RK1 b - d3 0 28", 6, 38633283 },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0", 5, 193690690 },
+    };
+
+    // no hash table, so that the counts depend on the
+    // move generator alone, and not on the zobrist keys
+    // or on entries stored by other threads
+    Perft perft(0);
+    quint64 total_nodes = 0;
+    qint64 total_msecs = 0;
+    int failed = 0;
+    for(const PerftCase &pc : cases) {
+        Board b = Board(QString(pc.fen));
+        std::cout << "Testing " << b.fen().toStdString() << std::endl;
+        std::cout << "Perft " << pc.depth << ", expected: " << pc.expected << std::endl;
+        PerftResult r = perft.run(b, pc.depth);
+        std::cout << "         computed: " << r.nodes
+                  << " (" << r.msecs << " ms, " << r.nps() << " nps)" << std::endl;
+        if(r.nodes != pc.expected) {
+            failed++;
+        }
+        total_nodes += r.nodes;
+        total_msecs += r.msecs;
+    }
+    std::cout << "Total: " << total_nodes << " nodes, " << total_msecs << " ms, "
+              << failed << " failed" << std::endl;
+}
+
+void chess::TestCases::run_polyglot_keys() {
+
+    struct KeyCase {
+        const char *uci;
+        // key after the move, 0 if the spec doesn't list one
+        quint64 expected;
+    };
+
+    // reference keys from the Polyglot book format specification.
+    // the first line ends with both kings moved, the second one
+    // has an en passant square and a capture of a rook on a1
+    KeyCase line_kings[] = {
+        { "e2e4", Q_UINT64_C(0x823c9b50fd114196) },
+        { "d7d5", Q_UINT64_C(0x0756b94461c50fb0) },
+        { "e4e5", Q_UINT64_C(0x662fafb965db29d4) },
+        { "f7f5", Q_UINT64_C(0x22a48b5a8e47ff78) },
+        { "e1e2", Q_UINT64_C(0x652a607ca3f242c1) },
+        { "e8f7", Q_UINT64_C(0x00fdd303c946bdd9) },
+    };
+    KeyCase line_ep[] = {
+        { "a2a4", 0 },
+        { "b7b5", 0 },
+        { "h2h4", 0 },
+        { "b5b4", 0 },
+        { "c2c4", Q_UINT64_C(0x3c8123ea7b067637) },
+        { "b4c3", 0 },
+        { "a1a3", Q_UINT64_C(0x5c3f9b829b279560) },
+    };
+    struct KeyLine {
+        KeyCase *moves;
+        int count;
+    };
+    KeyLine lines[] = {
+        { line_kings, int(sizeof(line_kings) / sizeof(KeyCase)) },
+        { line_ep, int(sizeof(line_ep) / sizeof(KeyCase)) },
+    };
+
+    const quint64 start_key = Q_UINT64_C(0x463b96181691fc9c);
+    int failed = 0;
+    for(const KeyLine &line : lines) {
+        Board b(true);
+        if(b.get_zobrist() != start_key) {
+            std::cout << "start position: wrong key" << std::endl;
+            failed++;
+        }
+        for(int i=0;i<line.count;i++) {
+            const KeyCase &kc = line.moves[i];
+            b.apply(Move(QString(kc.uci)));
+            quint64 key = b.get_zobrist();
+            if(kc.expected != 0 && key != kc.expected) {
+                std::cout << kc.uci << ": expected " << std::hex << kc.expected
+                          << ", computed " << key << std::dec << std::endl;
+                failed++;
+            }
+            // the incremental key must equal a key built from scratch
+            if(key != Board(b.fen()).get_zobrist()) {
+                std::cout << kc.uci << ": key differs from fen" << std::endl;
+                failed++;
+            }
+        }
+        for(int i=0;i<line.count;i++) {
             b.undo();
-            // /QString old_fen1 = b.fen();
-            // /if(QString::compare(old_fen, old_fen1, Qt::CaseInsensitive) != 0) {
-            // /    int foobar = QString::compare(old_fen, old_fen1, Qt::CaseInsensitive);
-            // /    std::cout << "MAJOR FOOBAR: " << foobar << std::endl;
-            // /    std::cout << "MOVE: " << m.uci().toStdString() << std::endl;
-            // /    std::cout << "OLD: " << old_fen.toStdString() << std::endl;
-            // /    std::cout << "NEW: " << old_fen1.toStdString() << std::endl;
-            // /}
         }
-        return count;
+        if(b.get_zobrist() != start_key) {
+            std::cout << "start position after undo: wrong key" << std::endl;
+            failed++;
+        }
     }
+    std::cout << "Polyglot keys: " << failed << " failed" << std::endl;
+}
 
+// games with what is easy to get wrong when lines are classified
+// on raw bytes: '%' lines before, between and within the headers,
+// header lines inside comments, and comments that span many lines
+// and thus cross the split points of a file scanned in parts
+static QByteArray scanner_fixture() {
+    QByteArray pgn;
+    pgn += "% exported for testing\n";
+    for(int i=0;i<12;i++) {
+        pgn += "[Event \"Game " + QByteArray::number(i) + "\"]\n";
+        pgn += "[Site \"?\"]\n";
+        if(i % 3 == 0) {
+            pgn += "% escaped line between headers\n";
+        }
+        pgn += "[Result \"*\"]\n";
+        if(i % 4 != 1) {
+            pgn += "\n";
+        }
+        pgn += "1. e4 { a comment that spans\n";
+        for(int j=0;j<(i % 4) * 6;j++) {
+            pgn += "[Event \"not a header\"] inside of a comment\n";
+            if(j % 3 == 1) {
+                pgn += "% { braces in escaped lines } don't count {\n";
+                pgn += "\n";
+            }
+        }
+        pgn += "several lines } e5 {x} {y\n";
+        pgn += "} 2. Nf3 { open } { and open again\n";
+        pgn += "[Event \"still in a comment\"]\n";
+        pgn += "closed } *\n";
+        if(i % 5 != 2) {
+            pgn += "\n";
+        }
+        if(i % 4 == 3) {
+            pgn += "% between games\n\n";
+        }
+    }
+    return pgn;
 }
 
-void chess::TestCases::run_pertf() {
+void chess::TestCases::run_pgn_scanner() {
+
+    QByteArray lf = scanner_fixture();
+    QByteArray crlf = lf;
+    crlf.replace("\n", "\r\n");
+    QByteArray bom("\xEF\xBB\xBF");
+
+    QVector<QByteArray> inputs;
+    inputs.append(lf);
+    inputs.append(crlf);
+    inputs.append(bom + lf);
+    inputs.append(bom + crlf);
+    // no newline at the end of the last line
+    inputs.append(lf.left(lf.size() - 2));
+
+    QVector<const char*> kernels = PgnScanner::kernelNames();
+    PgnReader reader;
+    int failed = 0;
+    for(int i=0;i<inputs.size();i++) {
+        const QByteArray &pgn = inputs.at(i);
+        QTemporaryFile file;
+        if(!file.open()) {
+            std::cout << "unable to create temporary file" << std::endl;
+            return;
+        }
+        file.write(pgn);
+        file.close();
+        QString filename = file.fileName();
+
+        QVector<qint64> expected = reader.scanPgn1(filename, true);
+        if(expected.size() != 12) {
+            std::cout << "input " << i << ": reference found "
+                      << expected.size() << " games" << std::endl;
+            failed++;
+        }
+        if(reader.scanPgn(filename, true) != expected) {
+            std::cout << "input " << i << ": scanPgn differs" << std::endl;
+            failed++;
+        }
+        for(int k=0;k<kernels.size();k++) {
+            for(int parts=1;parts<=24;parts++) {
+                QVector<qint64> offsets = scanPgnData(pgn.constData(), pgn.size(), true, parts, kernels.at(k));
+                if(offsets != expected) {
+                    std::cout << "input " << i << ": kernel " << kernels.at(k)
+                              << " with " << parts << " parts differs" << std::endl;
+                    failed++;
+                }
+            }
+        }
+    }
+    std::cout << "PgnScanner (" << kernels.size() << " kernels): "
+              << failed << " failed" << std::endl;
+}
+
+// a few games that cover the parser: variations, comments, NAGs,
+// FEN positions, castling, promotion and an illegal move. each is
+// repeated, so that readers that work in batches get many games
+static QByteArray games_fixture(int repeat) {
+    const char *games[] = {
+        "[Site \"?\"]\n"
+        "[Date \"2020.01.01\"]\n"
+        "[Round \"1\"]\n"
+        "[White \"White, A.\"]\n"
+        "[Black \"Black, B.\"]\n"
+        "[Result \"1-0\"]\n"
+        "[ECO \"C60\"]\n"
+        "\n"
+        "1. e4 e5 2. Nf3 (2. f4 exf4 3. Nf3 (3. Bc4 Qh4+ 4. Kf1) g5) 2... Nc6\n"
+        "3. Bb5 $1 a6 {Morphy defence} 4. Ba4 Nf6 $14 5. O-O Be7 1-0\n",
+
+        "[Site \"Paris\"]\n"
+        "[White \"Morphy\"]\n"
+        "[Black \"Duke Karl / Count Isouard\"]\n"
+        "[Result \"1-0\"]\n"
+        "[Annotator \"?\"]\n"
+        "\n"
+        "{The opera game} 1. e4 e5 2. Nf3 d6 3. d4 Bg4 4. dxe5 Bxf3 5. Qxf3 dxe5\n"
+        "6. Bc4 Nf6 7. Qb3 Qe7 8. Nc3 c6 9. Bg5 b5 10. Nxb5 cxb5 11. Bxb5+ Nbd7\n"
+        "12. O-O-O Rd8 13. Rxd7 Rxd7 14. Rd1 Qe6 15. Bxd7+ Nxd7 16. Qb8+ Nxb8\n"
+        "17. Rd8# 1-0\n",
+
+        "[White \"\"]\n"
+        "[Black \"\"]\n"
+        "[Result \"1/2-1/2\"]\n"
+        "[FEN \"8/8/8/4k3/8/8/4P3/4K3 w - - 0 1\"]\n"
+        "[SetUp \"1\"]\n"
+        "\n"
+        "1. e4 Kd6 2. Kd2 Ke5 3. Ke3 {opposition} $10 Kd6 1/2-1/2\n",
+
+        "[Result \"*\"]\n"
+        "[FEN \"8/P7/8/8/8/8/8/k6K w - - 0 1\"]\n"
+        "\n"
+        "1. a8=Q+ (1. a8=N Kb2) 1... Kb2 2. Qb7+ *\n",
+
+        "[Result \"*\"]\n"
+        "\n"
+        "1. e4 e5 2. Ke3 Nc6 *\n",
+    };
+    const int count = int(sizeof(games) / sizeof(games[0]));
+    QByteArray pgn;
+    for(int i=0;i<repeat;i++) {
+        for(int j=0;j<count;j++) {
+            pgn += "[Event \"Game " + QByteArray::number(i * count + j) + "\"]\n";
+            pgn += games[j];
+            pgn += "\n";
+        }
+    }
+    return pgn;
+}
+
+void chess::TestCases::run_pgn_bulk_reader() {
+
+    QTemporaryFile file;
+    if(!file.open()) {
+        std::cout << "unable to create temporary file" << std::endl;
+        return;
+    }
+    file.write(games_fixture(60));
+    file.close();
+    QString filename = file.fileName();
+
+    PgnReader reader;
+    PgnPrinter printer;
+    QVector<qint64> offsets = reader.scanPgn(filename, true);
+    int failed = 0;
+    if(offsets.size() != 300) {
+        std::cout << "found " << offsets.size() << " games instead of 300" << std::endl;
+        failed++;
+    }
+
+    // reference: one by one from a text stream
+    QVector<QString> expected;
+    QVector<int> expected_status;
+    QFile in_file(filename);
+    if(!in_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        std::cout << "unable to open " << filename.toStdString() << std::endl;
+        return;
+    }
+    QTextStream in(&in_file);
+    in.setCodec(QTextCodec::codecForName("UTF-8"));
+    for(int i=0;i<offsets.size();i++) {
+        Game g;
+        in.seek(offsets.at(i));
+        expected_status.append(reader.readGame(in, &g));
+        expected.append(printer.printGame(g).join("\n"));
+    }
+    in_file.close();
+
+    for(int pass=0;pass<2;pass++) {
+        bool in_order = pass == 0;
+        // more threads than games per batch, so that
+        // workers actually run concurrently
+        PgnBulkReader bulk(4, in_order);
+        QVector<QString> games(offsets.size());
+        QVector<int> status(offsets.size(), -2);
+        int delivered = 0;
+        bool ordered = true;
+        bulk.readGames(filename, offsets, true, [&](int i, Game *g, int st) {
+            if(i != delivered) {
+                ordered = false;
+            }
+            games[i] = printer.printGame(*g).join("\n");
+            status[i] = st;
+            delivered++;
+            delete g;
+        });
+        const char *name = in_order ? "in order" : "in completion order";
+        if(in_order && !ordered) {
+            std::cout << name << ": games delivered out of order" << std::endl;
+            failed++;
+        }
+        if(delivered != offsets.size()) {
+            std::cout << name << ": " << delivered << " games delivered" << std::endl;
+            failed++;
+        }
+        for(int i=0;i<offsets.size();i++) {
+            if(games.at(i) != expected.at(i) || status.at(i) != expected_status.at(i)) {
+                std::cout << name << ": game " << i << " differs" << std::endl;
+                failed++;
+            }
+        }
+    }
+    std::cout << "PgnBulkReader: " << failed << " failed" << std::endl;
+}
+
+// main line of a game as uci strings, plus the result
+static QStringList main_line(chess::Game &g) {
+    QStringList moves;
+    chess::GameNode *node = g.getRootNode();
+    while(!node->isLeaf()) {
+        node = node->getVariation(0);
+        moves.append(node->getMove().uci());
+    }
+    moves.append(QString::number(g.getResult()));
+    return moves;
+}
+
+void chess::TestCases::run_moves_only() {
+
+    // comments may contain empty lines, both in the main line
+    // and in variations that moves-only mode skips
+    QByteArray pgn = games_fixture(1);
+    pgn += "[Event \"Empty lines in comments\"]\n"
+           "[Result \"1-0\"]\n"
+           "\n"
+           "{An opening comment\n"
+           "\n"
+           "over two paragraphs} 1. e4 {a comment\n"
+           "\n"
+           "with an empty line} e5 2. Nf3 (2. f4 {a side line\n"
+           "\n"
+           "comment} exf4) 2... Nc6 {\n"
+           "\n"
+           "} 3. Bb5 1-0\n"
+           "\n";
+    pgn += "[Event \"After the empty lines\"]\n"
+           "[Result \"0-1\"]\n"
+           "\n"
+           "1. f3 e5 2. g4 Qh4# 0-1\n"
+           "\n";
+    QVector<qint64> offsets = scanPgnData(pgn.constData(), pgn.size(), true, 1);
+    int failed = 0;
+    if(offsets.size() != 7) {
+        std::cout << "found " << offsets.size() << " games instead of 7" << std::endl;
+        failed++;
+    }
+
+    for(int i=0;i<offsets.size();i++) {
+        const char *data = pgn.constData() + offsets.at(i);
+        qint64 len = pgn.size() - offsets.at(i);
+
+        PgnReader reader;
+        Game full;
+        reader.readGame(data, len, true, &full);
+        QStringList expected = main_line(full);
+
+        reader.setMovesOnly(true);
+        Game nodes;
+        reader.readGame(data, len, true, &nodes);
+        if(main_line(nodes) != expected) {
+            std::cout << "game " << i << ": moves-only main line differs" << std::endl;
+            failed++;
+        }
+
+        QStringList moves;
+        reader.setMoveCallback([&moves](const Board &, const Move &m) {
+            moves.append(m.uci());
+            return true;
+        });
+        Game callback;
+        reader.readGame(data, len, true, &callback);
+        moves.append(QString::number(callback.getResult()));
+        if(moves != expected) {
+            std::cout << "game " << i << ": callback main line differs" << std::endl;
+            failed++;
+        }
+    }
+    std::cout << "moves-only: " << failed << " failed" << std::endl;
+}
+
+// compares an index with a fresh scan of the file
+static bool index_matches_file(const chess::PgnIndex &index, QString &filename) {
+    chess::PgnReader reader;
+    QVector<qint64> offsets = reader.scanPgn(filename, true);
+    if(index.getOffsets() != offsets) {
+        return false;
+    }
+    if(!index.hasHeaders()) {
+        return true;
+    }
+    chess::PgnHeaderTable headers;
+    headers.read(filename, offsets, true);
+    const chess::PgnHeaderTable &indexed = index.getHeaders();
+    if(indexed.size() != headers.size()) {
+        return false;
+    }
+    for(int i=0;i<headers.size();i++) {
+        for(int j=0;j<chess::PgnHeaderTable::COLUMN_COUNT;j++) {
+            chess::PgnHeaderTable::Column column = chess::PgnHeaderTable::Column(j);
+            if(indexed.value(i, column) != headers.value(i, column)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool write_file(const QString &filename, const QByteArray &data, bool append) {
+    QFile file(filename);
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if(append) {
+        mode |= QIODevice::Append;
+    }
+    if(!file.open(mode)) {
+        return false;
+    }
+    bool ok = file.write(data) == data.size();
+    file.close();
+    return ok;
+}
 
-    // initial position tests, perft 1 - 6
-    Board b = Board(QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 1, expected: 20" << std::endl;
-    int c = count_moves(b,0);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 2, expected: 400" << std::endl;
-    c = count_moves(b,1);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 3, expected: 8902" << std::endl;
-    c = count_moves(b,2);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 4, expected: 197281" << std::endl;
-    c = count_moves(b,3);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 5, expected: 4865609" << std::endl;
-    c = count_moves(b,4);
-    std::cout << "         computed: " << c << std::endl;
-
-    // "Kiwipete" by Peter McKenzie, great for identifying bugs
-    // perft 1 - 5
-    b = Board(QString("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 1, expected: 48" << std::endl;
-    c = count_moves(b,0);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 2, expected: 2039" << std::endl;
-    c = count_moves(b,1);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 3, expected: 97862" << std::endl;
-    c = count_moves(b,2);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 4, expected: 4085603" << std::endl;
-    c = count_moves(b,3);
-    std::cout << "         computed: " << c << std::endl;
-
-    // some more pos. for bug-hunting, taken from chessprogramming wiki and
-    // Sharper by Albert Bertilsson's homepage
-    // perft 1 - 2
-    b = Board(QString("8/3K4/2p5/p2b2r1/5k2/8/8/1q6 b - - 1 67"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 1, expected: 50" << std::endl;
-    c = count_moves(b,0);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("8/3K4/2p5/p2b2r1/5k2/8/8/1q6 b - - 1 67"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 2, expected: 279" << std::endl;
-    c = count_moves(b,1);
-    std::cout << "         computed: " << c << std::endl;
-
-    // perft 5
-    b = Board(QString("rnbqkb1r/ppppp1pp/7n/4Pp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 5, expected: 11139762" << std::endl;
-    c = count_moves(b,4);
-    std::cout << "         computed: " << c << std::endl;
-
-    // perft 1 - 5
-    b = Board(QString("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 1, expected: 44" << std::endl;
-    c = count_moves(b,0);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 2, expected: 1486" << std::endl;
-    c = count_moves(b,1);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 3, expected: 62379" << std::endl;
-    c = count_moves(b,2);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 4, expected: 2103487" << std::endl;
-    c = count_moves(b,3);
-    std::cout << "         computed: " << c << std::endl;
-
-    // most computational intensive (i.e. deepest) of the above
-    // are at the end here
-    b = Board(QString("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 5, expected: 89941194" << std::endl;
-    c = count_moves(b,4);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 6, expected: 119060324" << std::endl;
-    c = count_moves(b,5);
-    std::cout << "         computed: " << c << std::endl;
-
-    // perft 6
-    b = Board(QString("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 6, expected: 11030083" << std::endl;
-    c = count_moves(b,5);
-    std::cout << "         computed: " << c << std::endl;
-
-    // perft 7
-    qDebug() << "perft7";
-    b = Board(QString("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 7, expected: 178633661" << std::endl;
-    c = count_moves(b,6);
-    std::cout << "         computed: " << c << std::endl;
-
-    // perft 6
-    b = Board(QString("8/7p/p5pb/4k3/P1pPn3/8/P5PP/1rB2RK1 b - d3 0 28"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 6, expected: 38633283" << std::endl;
-    c = count_moves(b,5);
-    std::cout << "         computed: " << c << std::endl;
-
-    b = Board(QString("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0"));
-    std::cout << "Testing " << b.fen().toStdString() << std::endl;
-    std::cout << "Perft 5, expected: 193690690" << std::endl;
-    c = count_moves(b,4);
-    std::cout << "         computed: " << c << std::endl;
+void chess::TestCases::run_pgn_index() {
 
+    QTemporaryFile file;
+    if(!file.open()) {
+        std::cout << "unable to create temporary file" << std::endl;
+        return;
+    }
+    file.close();
+    QString filename = file.fileName();
+    QString idx_filename = PgnIndex::indexFilename(filename);
+    QByteArray pgn = games_fixture(20);
+    int failed = 0;
+
+    struct IndexStep {
+        const char *name;
+        int expected;
+    };
+    IndexStep steps[] = {
+        { "new file", PGN_INDEX_REBUILT },
+        { "unchanged file", PGN_INDEX_CURRENT },
+        { "appended games", PGN_INDEX_APPENDED },
+        { "unchanged after append", PGN_INDEX_CURRENT },
+        { "rewritten at the same size", PGN_INDEX_REBUILT },
+        { "corrupt sidecar", PGN_INDEX_REBUILT },
+        { "truncated sidecar", PGN_INDEX_REBUILT },
+    };
+    for(int i=0;i<int(sizeof(steps) / sizeof(IndexStep));i++) {
+        const IndexStep &step = steps[i];
+        bool ok = true;
+        if(i == 0) {
+            QFile::remove(idx_filename);
+            ok = write_file(filename, pgn, false);
+        } else if(i == 2) {
+            ok = write_file(filename, games_fixture(3), true);
+        } else if(i == 4) {
+            QFile in(filename);
+            ok = in.open(QIODevice::ReadOnly);
+            QByteArray content = in.read(in.size());
+            in.close();
+            // same size and checksum range, other content
+            content.replace("Game 1", "Game X");
+            ok = ok && write_file(filename, content, false);
+        } else if(i == 5) {
+            // a valid header, followed by an absurd offset count
+            QFile out(idx_filename);
+            ok = out.open(QIODevice::WriteOnly);
+            QDataStream ds(&out);
+            ds.setVersion(QDataStream::Qt_5_0);
+            ds << quint32(0x434c4958) << quint32(1);
+            ds << true << qint64(0) << qint64(0) << quint64(0);
+            ds << quint32(0x7fffffff) << qint64(0);
+            out.close();
+        } else if(i == 6) {
+            QFile in(idx_filename);
+            ok = in.open(QIODevice::ReadOnly);
+            QByteArray content = in.read(in.size());
+            in.close();
+            ok = ok && write_file(idx_filename, content.left(content.size() / 2), false);
+        }
+        if(!ok) {
+            std::cout << step.name << ": unable to prepare files" << std::endl;
+            failed++;
+            continue;
+        }
+        PgnIndex index;
+        int result = index.open(filename, true, true);
+        if(result != step.expected) {
+            std::cout << step.name << ": expected " << step.expected
+                      << ", got " << result << std::endl;
+            failed++;
+        }
+        if(!index_matches_file(index, filename)) {
+            std::cout << step.name << ": index differs from a new scan" << std::endl;
+            failed++;
+        }
+    }
+    QFile::remove(idx_filename);
+    std::cout << "PgnIndex: " << failed << " failed" << std::endl;
+}
+
+void chess::TestCases::run_pgn_header_table() {
+
+    // a latin1 file, with the utf8 bytes of "\u00e9" read as "\u00c3\u00a9"
+    QByteArray pgn = "[White \"\xC3\xA9\"]\n[Black \"?\"]\n\n1. e4 *\n";
+    QString e_acute = QString::fromUtf8("\xC3\xA9");
+    // no latin1 bytes for the euro sign, and toLatin1() makes it a "?"
+    QString euro = QString::fromUtf8("\xE2\x82\xAC");
+
+    PgnHeaderTable table;
+    table.append(0, pgn.constData(), pgn.size(), false);
+    PgnHeader header;
+    header.white = e_acute;
+    header.black = euro;
+    table.append(1, header);
+
+    struct Expected {
+        int row;
+        PgnHeaderTable::Column column;
+        QString value;
+    };
+    Expected expected[] = {
+        { 0, PgnHeaderTable::WHITE, QString::fromLatin1("\xC3\xA9") },
+        { 0, PgnHeaderTable::BLACK, QString("?") },
+        { 1, PgnHeaderTable::WHITE, e_acute },
+        { 1, PgnHeaderTable::BLACK, euro },
+        { 2, PgnHeaderTable::WHITE, e_acute },
+        { 2, PgnHeaderTable::BLACK, euro },
+        { 3, PgnHeaderTable::WHITE, QString::fromLatin1("\xC3\xA9") },
+        { 3, PgnHeaderTable::BLACK, QString("?") },
+    };
+    const int count = int(sizeof(expected) / sizeof(Expected));
+
+    int failed = 0;
+    QTemporaryFile file;
+    if(!file.open()) {
+        std::cout << "unable to create temporary file" << std::endl;
+        return;
+    }
+    for(int pass=0;pass<2;pass++) {
+        if(pass == 1) {
+            // the string index is rebuilt on load, values added
+            // afterwards must still find the right strings
+            QDataStream out(&file);
+            out.setVersion(QDataStream::Qt_5_0);
+            table.save(out);
+            file.close();
+            QFile in_file(file.fileName());
+            bool ok = in_file.open(QIODevice::ReadOnly);
+            QDataStream in(&in_file);
+            in.setVersion(QDataStream::Qt_5_0);
+            QVector<qint64> offsets;
+            offsets.append(0);
+            offsets.append(1);
+            if(!ok || !table.load(in, offsets, false)) {
+                std::cout << "unable to load the table" << std::endl;
+                failed++;
+                break;
+            }
+        }
+        table.append(2, header);
+        table.append(3, pgn.constData(), pgn.size(), false);
+        for(int i=0;i<count;i++) {
+            const Expected &e = expected[i];
+            if(table.value(e.row, e.column) != e.value) {
+                std::cout << "pass " << pass << ", row " << e.row
+                          << ": wrong value in column " << e.column << std::endl;
+                failed++;
+            }
+        }
+        table.truncate(2);
+    }
+    std::cout << "PgnHeaderTable: " << failed << " failed" << std::endl;
+}
+
+void chess::TestCases::run_game_db() {
+
+    // the fixture has variations, comments at the root and at moves,
+    // NAGs, FEN positions, extra tags and empty roster values
+    QByteArray pgn = games_fixture(2);
+    pgn += "[Event \"\"]\n"
+           "[ECO \"\"]\n"
+           "[Result \"*\"]\n"
+           "\n"
+           "1. d4 d5 *\n"
+           "\n";
+    QVector<qint64> offsets = scanPgnData(pgn.constData(), pgn.size(), true, 1);
+    int failed = 0;
+    if(offsets.size() != 11) {
+        std::cout << "found " << offsets.size() << " games instead of 11" << std::endl;
+        failed++;
+    }
+
+    PgnReader reader;
+    PgnPrinter printer;
+    GameDb db;
+    QVector<QStringList> expected_tags;
+    QVector<QString> expected;
+    for(int i=0;i<offsets.size();i++) {
+        Game g;
+        reader.readGame(pgn.constData() + offsets.at(i), pgn.size() - offsets.at(i), true, &g);
+        db.append(g);
+        // printing creates missing roster tags, so get the tags first
+        expected_tags.append(g.getTags());
+        expected.append(printer.printGame(g).join("\n"));
+    }
+
+    QTemporaryFile file;
+    if(!file.open()) {
+        std::cout << "unable to create temporary file" << std::endl;
+        return;
+    }
+    file.close();
+    QString filename = file.fileName();
+    GameDb loaded;
+    if(!db.save(filename) || !loaded.load(filename)) {
+        std::cout << "unable to save and load " << filename.toStdString() << std::endl;
+        failed++;
+    }
+    if(loaded.size() != expected.size()) {
+        std::cout << "loaded " << loaded.size() << " games instead of "
+                  << expected.size() << std::endl;
+        failed++;
+    }
+    for(int i=0;i<loaded.size() && i<expected.size();i++) {
+        Game g;
+        if(!loaded.readGame(i, &g)) {
+            std::cout << "game " << i << ": unable to read" << std::endl;
+            failed++;
+            continue;
+        }
+        if(g.getTags() != expected_tags.at(i)) {
+            std::cout << "game " << i << ": tags differ" << std::endl;
+            failed++;
+        }
+        if(printer.printGame(g).join("\n") != expected.at(i)) {
+            std::cout << "game " << i << ": game differs" << std::endl;
+            failed++;
+        }
+    }
+    std::cout << "GameDb: " << failed << " failed" << std::endl;
 }
@@ -11,8 +11,53 @@ public:
     TestCases();
     void run_pertf();
 
-private:
-    int count_moves(Board b, int depth);
+    /**
+     * @brief run_polyglot_keys checks the incrementally updated keys
+     *        against the published Polyglot reference keys, both after
+     *        apply() and after undo()
+     */
+    void run_polyglot_keys();
+
+    /**
+     * @brief run_pgn_scanner checks that all classification kernels, and
+     *        files split into any number of parts, give the same game
+     *        offsets as the line based reference scanner
+     */
+    void run_pgn_scanner();
+
+    /**
+     * @brief run_pgn_bulk_reader checks that PgnBulkReader, delivering
+     *        in order and in completion order, reads the same games as
+     *        reading them one by one
+     */
+    void run_pgn_bulk_reader();
+
+    /**
+     * @brief run_moves_only checks that moves-only mode, with and without
+     *        a move callback, reads the same main lines as the full parser,
+     *        also across comments that contain empty lines
+     */
+    void run_moves_only();
+
+    /**
+     * @brief run_pgn_index checks that the sidecar index is loaded for
+     *        unchanged files, extended for appended ones, rebuilt for
+     *        rewritten ones, and that corrupt sidecars are rejected
+     */
+    void run_pgn_index();
+
+    /**
+     * @brief run_pgn_header_table checks that values read from a latin1
+     *        file and values appended as strings are kept apart, also
+     *        after the table was saved and loaded again
+     */
+    void run_pgn_header_table();
+
+    /**
+     * @brief run_game_db checks that games stored in a GameDb, saved
+     *        and loaded again, print the same as the original games
+     */
+    void run_game_db();
 
 };
 